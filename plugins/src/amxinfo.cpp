@@ -3,6 +3,9 @@
 #include "modules/tags.h"
 #include "modules/amxutils.h"
 #include <unordered_map>
+#include <deque>
+#include <vector>
+#include <atomic>
 
 #include "subhook/subhook.h"
 
@@ -16,6 +19,8 @@
 
 struct natives_extra : public amx::extra
 {
+	static constexpr amx::extra_slot slot = amx::extra_slot::natives;
+
 	natives_extra(AMX *amx) : extra(amx)
 	{
 
@@ -34,18 +39,120 @@ struct natives_extra : public amx::extra
 	}
 };
 
-static std::unordered_map<AMX*, std::shared_ptr<amx::instance>> amx_map;
+// Entry of amx_map referenced from a user data slot of the AMX, to find the instance without hashing.
+// Links are reused but never freed, so a stale slot (e.g. in a copy of the AMX) can always be checked safely.
+struct amx_link
+{
+	AMX *amx = nullptr;
+	const amx::object *obj = nullptr;
+};
+
+struct amx_entry
+{
+	amx::object obj;
+	amx_link *link = nullptr;
+
+	amx_entry(amx::object &&obj) : obj(std::move(obj))
+	{
+
+	}
+};
+
+static std::unordered_map<AMX*, amx_entry> amx_map;
+
+static const long amx_link_tag = AMX_USERTAG('P', 'P', 'l', 'k');
+static std::deque<amx_link> amx_links;
+static std::vector<amx_link*> free_links;
+
+static const amx::object *find_linked(AMX *amx)
+{
+	for(int i = 0; i < AMX_USERNUM; i++)
+	{
+		if(amx->usertags[i] == amx_link_tag)
+		{
+			auto link = static_cast<amx_link*>(amx->userdata[i]);
+			if(link->amx == amx)
+			{
+				return link->obj;
+			}
+			return nullptr;
+		}
+	}
+	return nullptr;
+}
+
+// the slot may be lost if the AMX is initialized later, in which case it is restored on the next lookup
+static const amx::object &link_entry(AMX *amx, amx_entry &entry)
+{
+	if(!entry.link)
+	{
+		if(free_links.empty())
+		{
+			amx_links.emplace_back();
+			entry.link = &amx_links.back();
+		}else{
+			entry.link = free_links.back();
+			free_links.pop_back();
+		}
+		entry.link->amx = amx;
+		entry.link->obj = &entry.obj;
+	}
+	int slot = -1;
+	for(int i = 0; i < AMX_USERNUM; i++)
+	{
+		if(amx->usertags[i] == amx_link_tag)
+		{
+			slot = i;
+			break;
+		}else if(slot == -1 && amx->usertags[i] == 0)
+		{
+			slot = i;
+		}
+	}
+	if(slot != -1)
+	{
+		amx->usertags[slot] = amx_link_tag;
+		amx->userdata[slot] = entry.link;
+	}
+	return entry.obj;
+}
+
+static void unlink_entry(AMX *amx, amx_entry &entry)
+{
+	if(entry.link)
+	{
+		for(int i = 0; i < AMX_USERNUM; i++)
+		{
+			if(amx->usertags[i] == amx_link_tag && amx->userdata[i] == entry.link)
+			{
+				amx->usertags[i] = 0;
+				amx->userdata[i] = nullptr;
+				break;
+			}
+		}
+		entry.link->amx = nullptr;
+		entry.link->obj = nullptr;
+		free_links.push_back(entry.link);
+		entry.link = nullptr;
+	}
+}
+
+size_t amx::next_extra_id()
+{
+	static std::atomic<size_t> counter(0);
+	return counter++;
+}
 
 bool amx::valid(AMX *amx)
 {
-	return amx_map.find(amx) != amx_map.end();
+	return find_linked(amx) || amx_map.find(amx) != amx_map.end();
 }
 
 void amx::call_all(void(*func)(void *cookie, AMX *amx), void *cookie)
 {
 	for(const auto &pair : amx_map)
 	{
-		if(pair.second->valid())
+		if(pair.second.obj->valid())
 		{
 			func(cookie, pair.first);
 		}
@@ -55,18 +162,23 @@ void amx::call_all(void(*func)(void *cookie, AMX *amx), void *cookie)
 // Nothing should be loaded from the AMX here, since it may not even be initialized yet
 const amx::object &amx::load_lock(AMX *amx)
 {
+	if(auto obj = find_linked(amx))
+	{
+		return *obj;
+	}
 	auto it = amx_map.find(amx);
-	if(it != amx_map.end())
+	if(it == amx_map.end())
 	{
-		return it->second;
+		it = amx_map.emplace(amx, amx_entry(std::make_shared<instance>(amx))).first;
 	}
-	return amx_map.emplace(amx, std::make_shared<instance>(amx)).first->second;
+	return link_entry(amx, it->second);
 }
 
 const amx::object &amx::clone_lock(AMX *amx, AMX *new_amx)
 {
 	const auto &obj = load_lock(amx);
-	return amx_map.emplace(new_amx, std::make_shared<instance>(*obj, new_amx)).first->second;
+	auto it = amx_map.emplace(new_amx, amx_entry(std::make_shared<instance>(*obj, new_amx))).first;
+	return link_entry(new_amx, it->second);
 }
 
 
@@ -75,6 +187,7 @@ bool amx::unload(AMX *amx)
 	auto it = amx_map.find(amx);
 	if(it != amx_map.end())
 	{
+		unlink_entry(amx, it->second);
 		amx_map.erase(it);
 		return true;
 	}
@@ -86,7 +199,7 @@ bool amx::invalidate(AMX *amx)
 	auto it = amx_map.find(amx);
 	if(it != amx_map.end())
 	{
-		it->second->invalidate();
+		it->second.obj->invalidate();
 		return true;
 	}
 	return false;
@@ -35,6 +35,183 @@ namespace amx
 		virtual ~extra() = default;
 	};
 
+	// Slots of the extras defined by the plugin, selected by their static member slot.
+	enum class extra_slot : size_t
+	{
+		natives,
+		context,
+		code_info,
+		fork_info,
+		fork_template,
+		forked_amx,
+		forked_context,
+		parallel_context,
+		error_level,
+		tag_map,
+		string_keys,
+		guards,
+		events,
+		format_cache,
+		threads,
+		tasks,
+		count
+	};
+
+	// Returns a new small integer for every type of extra without a slot.
+	size_t next_extra_id();
+
+	template <class ExtraType>
+	auto extra_id(int) -> decltype(ExtraType::slot, size_t())
+	{
+		static_assert(static_cast<size_t>(ExtraType::slot) < static_cast<size_t>(extra_slot::count), "extra slot is out of range");
+		return static_cast<size_t>(ExtraType::slot);
+	}
+
+	template <class ExtraType>
+	size_t extra_id(long)
+	{
+		static const size_t id = static_cast<size_t>(extra_slot::count) + next_extra_id();
+		return id;
+	}
+
+	template <class ExtraType>
+	size_t extra_id()
+	{
+		return extra_id<ExtraType>(0);
+	}
+
+	// Storage of extras by type. Types with a slot are stored in an inline array,
+	// others in a hash map.
+	class extra_set
+	{
+		static constexpr size_t slot_count = static_cast<size_t>(extra_slot::count);
+
+		std::unique_ptr<extra> slots[slot_count];
+		std::unordered_map<size_t, std::unique_ptr<extra>> overflow;
+
+		std::unique_ptr<extra> *find(size_t id)
+		{
+			if(id < slot_count)
+			{
+				return &slots[id];
+			}
+			auto it = overflow.find(id);
+			if(it != overflow.end())
+			{
+				return &it->second;
+			}
+			return nullptr;
+		}
+
+		const std::unique_ptr<extra> *find(size_t id) const
+		{
+			return const_cast<extra_set*>(this)->find(id);
+		}
+
+	public:
+		extra_set()
+		{
+
+		}
+
+		extra_set(const extra_set&) = delete;
+		extra_set(extra_set &&obj) : overflow(std::move(obj.overflow))
+		{
+			for(size_t i = 0; i < slot_count; i++)
+			{
+				slots[i] = std::move(obj.slots[i]);
+			}
+			obj.overflow.clear();
+		}
+
+		extra_set &operator=(const extra_set&) = delete;
+		extra_set &operator=(extra_set &&obj)
+		{
+			if(this != &obj)
+			{
+				for(size_t i = 0; i < slot_count; i++)
+				{
+					slots[i] = std::move(obj.slots[i]);
+				}
+				overflow = std::move(obj.overflow);
+				obj.overflow.clear();
+			}
+			return *this;
+		}
+
+		template <class ExtraType>
+		ExtraType &get(AMX *amx)
+		{
+			size_t id = extra_id<ExtraType>();
+			std::unique_ptr<extra> *ptr;
+			if(id < slot_count)
+			{
+				ptr = &slots[id];
+			}else{
+				ptr = &overflow[id];
+			}
+			if(!*ptr)
+			{
+				ptr->reset(new ExtraType(amx));
+			}
+			return static_cast<ExtraType&>(**ptr);
+		}
+
+		template <class ExtraType>
+		bool has() const
+		{
+			auto ptr = find(extra_id<ExtraType>());
+			return ptr && *ptr;
+		}
+
+		template <class ExtraType>
+		bool remove()
+		{
+			size_t id = extra_id<ExtraType>();
+			if(id < slot_count)
+			{
+				if(slots[id])
+				{
+					slots[id] = nullptr;
+					return true;
+				}
+				return false;
+			}
+			return overflow.erase(id) > 0;
+		}
+
+		void clone_from(const extra_set &obj)
+		{
+			for(size_t i = 0; i < slot_count; i++)
+			{
+				if(obj.slots[i])
+				{
+					slots[i] = obj.slots[i]->clone();
+				}
+			}
+			for(const auto &pair : obj.overflow)
+			{
+				if(pair.second)
+				{
+					auto clone = pair.second->clone();
+					if(clone)
+					{
+						overflow[pair.first] = std::move(clone);
+					}
+				}
+			}
+		}
+
+		void clear()
+		{
+			for(size_t i = 0; i < slot_count; i++)
+			{
+				slots[i] = nullptr;
+			}
+			overflow.clear();
+		}
+	};
+
 	typedef std::weak_ptr<class instance> handle;
 	typedef std::shared_ptr<class instance> object;
 
@@ -45,7 +222,7 @@ namespace amx
 		friend bool invalidate(AMX *amx);
 
 		AMX *_amx;
-		std::unordered_map<std::type_index, std::unique_ptr<extra>> extras;
+		extra_set extras;
 		bool initialized = false;
 
 		void invalidate()
@@ -69,17 +246,7 @@ namespace amx
 
 		instance(const instance &obj, AMX *new_amx) : _amx(new_amx), name(obj.name), dbg(obj.dbg)
 		{
-			for(const auto &pair : obj.extras)
-			{
-				if(pair.second)
-				{
-					auto clone = pair.second->clone();
-					if(clone)
-					{
-						extras[pair.first] = std::move(clone);
-					}
-				}
-			}
+			extras.clone_from(obj.extras);
 		}
 
 		instance(const instance &obj) = delete;
@@ -113,36 +280,19 @@ namespace amx
 		template <class ExtraType>
 		ExtraType &get_extra()
 		{
-			std::type_index key = typeid(ExtraType);
-
-			auto it = extras.find(key);
-			if(it == extras.end())
-			{
-				it = extras.insert(std::make_pair(key, std::unique_ptr<ExtraType>(new ExtraType(_amx)))).first;
-			}
-			return static_cast<ExtraType&>(*it->second);
+			return extras.get<ExtraType>(_amx);
 		}
 
 		template <class ExtraType>
 		bool has_extra() const
 		{
-			std::type_index key = typeid(ExtraType);
-
-			return extras.find(key) != extras.end();
+			return extras.has<ExtraType>();
 		}
 
 		template <class ExtraType>
 		bool remove_extra()
 		{
-			std::type_index key = typeid(ExtraType);
-
-			auto it = extras.find(key);
-			if(it != extras.end())
-			{
-				extras.erase(it);
-				return true;
-			}
-			return false;
+			return extras.remove<ExtraType>();
 		}
 
 		AMX *get()
@@ -14,6 +14,8 @@ const int &amx::context_level = globalExecLevel;
 
 struct AMX_STATE : public amx::extra
 {
+	static constexpr amx::extra_slot slot = amx::extra_slot::context;
+
 	std::deque<amx::context> contexts;
 
 	AMX_STATE(AMX *amx) : amx::extra(amx)
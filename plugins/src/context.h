@@ -46,7 +46,7 @@ namespace amx
 	{
 		AMX *_amx;
 		int _index;
-		std::unordered_map<std::type_index, std::unique_ptr<extra>> extras;
+		extra_set extras;
 
 	public:
 		context() : _amx(nullptr), _index(0)
@@ -88,36 +88,19 @@ namespace amx
 		template <class ExtraType>
 		ExtraType &get_extra()
 		{
-			std::type_index key = typeid(ExtraType);
-
-			auto it = extras.find(key);
-			if(it == extras.end())
-			{
-				it = extras.insert(std::make_pair(key, std::unique_ptr<ExtraType>(new ExtraType(_amx)))).first;
-			}
-			return static_cast<ExtraType&>(*it->second);
+			return extras.get<ExtraType>(_amx);
 		}
 
 		template <class ExtraType>
 		bool has_extra() const
 		{
-			std::type_index key = typeid(ExtraType);
-
-			return extras.find(key) != extras.end();
+			return extras.has<ExtraType>();
 		}
 
 		template <class ExtraType>
 		bool remove_extra()
 		{
-			std::type_index key = typeid(ExtraType);
-
-			auto it = extras.find(key);
-			if(it != extras.end())
-			{
-				extras.erase(it);
-				return true;
-			}
-			return false;
+			return extras.remove<ExtraType>();
 		}
 	};
 
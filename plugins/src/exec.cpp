@@ -10,16 +10,166 @@
 #include "modules/amxutils.h"
 #include "modules/debug.h"
 #include "modules/containers.h"
+#include "utils/cow_image.h"
 #include "fixes/linux.h"
 
 #include <cstring>
 #include <limits>
+#include <mutex>
+#include <atomic>
 
 int maxRecursionLevel = std::numeric_limits<int>::max();
+size_t fork_pool_size = 4;
+
+static std::atomic<size_t> fork_pool_created(0);
+static std::atomic<size_t> fork_pool_reused(0);
+static std::atomic<size_t> fork_pool_idle(0);
+
+// Initialized machine whose header and code are shared by all forks of a program, with the initial data as a copy-on-write image
+struct fork_template
+{
+	AMX amx;
+	bool initialized = false;
+	std::unique_ptr<unsigned char[]> base;
+	std::unique_ptr<unsigned char[]> header;
+	std::unique_ptr<unsigned char[]> code;
+	std::unique_ptr<aux::cow_image> data;
+
+	// finished forks kept for reuse, up to fork_pool_size
+	std::mutex pool_mutex;
+	std::vector<AMX*> pool;
+
+	int init(AMX *amx, const unsigned char *code)
+	{
+		auto amxhdr = (AMX_HEADER*)amx->base;
+		header = std::make_unique<unsigned char[]>(amxhdr->cod);
+		std::memcpy(header.get(), amx->base, amxhdr->cod);
+		this->code = std::make_unique<unsigned char[]>(amxhdr->size - amxhdr->cod);
+		std::memcpy(this->code.get(), code, amxhdr->size - amxhdr->cod);
+
+		base = std::make_unique<unsigned char[]>(amxhdr->stp);
+		std::memcpy(base.get(), amx->base, amxhdr->cod); // copy header
+		std::memcpy(base.get() + amxhdr->cod, code, amxhdr->size - amxhdr->cod); // copy original code
+		std::memset(&this->amx, 0, sizeof(AMX));
+		int initret = amx_InitOrig(&this->amx, base.get());
+		if(initret != AMX_ERR_NONE)
+		{
+			return initret;
+		}
+		initialized = true;
+		this->amx.callback = amx_Callback;
+		this->amx.flags |= AMX_FLAG_NTVREG;
+		data = std::make_unique<aux::cow_image>(base.get() + amxhdr->dat, amxhdr->stp - amxhdr->dat);
+		return AMX_ERR_NONE;
+	}
+
+	// the template must be recreated when the header of the program (e.g. its natives) is changed
+	bool matches(AMX *amx) const
+	{
+		auto amxhdr = (AMX_HEADER*)amx->base;
+		return std::memcmp(header.get(), amx->base, amxhdr->cod) == 0;
+	}
+
+	// returns a fork in the initial state of the template, optionally keeping the data of a reused fork
+	AMX *acquire(bool initial_data)
+	{
+		AMX *fork = nullptr;
+		{
+			std::lock_guard<std::mutex> lock(pool_mutex);
+			if(!pool.empty())
+			{
+				fork = pool.back();
+				pool.pop_back();
+				fork_pool_idle--;
+			}
+		}
+		unsigned char *fork_data;
+		if(fork)
+		{
+			fork_data = fork->data;
+			if(initial_data)
+			{
+				fork_data = data->reset_copy(fork_data);
+				if(!fork_data)
+				{
+					delete fork;
+					return nullptr;
+				}
+			}
+			*fork = amx;
+			fork_pool_reused++;
+		}else{
+			fork_data = data->make_copy();
+			if(!fork_data)
+			{
+				return nullptr;
+			}
+			fork = new AMX(amx);
+			fork_pool_created++;
+		}
+		fork->data = fork_data;
+		return fork;
+	}
+
+	void release(AMX *fork)
+	{
+		{
+			std::lock_guard<std::mutex> lock(pool_mutex);
+			if(pool.size() < fork_pool_size)
+			{
+				pool.push_back(fork);
+				fork_pool_idle++;
+				return;
+			}
+		}
+		data->free_copy(fork->data);
+		delete fork;
+	}
+
+	~fork_template()
+	{
+		for(AMX *fork : pool)
+		{
+			data->free_copy(fork->data);
+			delete fork;
+		}
+		fork_pool_idle -= pool.size();
+		if(initialized)
+		{
+			amx_Cleanup(&amx);
+		}
+	}
+};
+
+struct fork_template_extra : public amx::extra
+{
+	static constexpr amx::extra_slot slot = amx::extra_slot::fork_template;
+
+	std::shared_ptr<fork_template> templ;
+
+	fork_template_extra(AMX *amx) : amx::extra(amx)
+	{
+
+	}
+
+	fork_template_extra(AMX *amx, const std::shared_ptr<fork_template> &templ) : amx::extra(amx), templ(templ)
+	{
+
+	}
+
+	virtual std::unique_ptr<extra> clone() override
+	{
+		return std::unique_ptr<extra>(new fork_template_extra(_amx, templ));
+	}
+};
 
 // Automatically destroys the AMX machine when the info instance is destroyed (i.e. the AMX becomes unused)
 struct forked_amx_holder : public amx::extra
 {
+	static constexpr amx::extra_slot slot = amx::extra_slot::forked_amx;
+
+	std::shared_ptr<fork_template> templ;
+
 	forked_amx_holder(AMX *amx) : amx::extra(amx)
 	{
 
@@ -28,13 +178,14 @@ struct forked_amx_holder : public amx::extra
 	virtual ~forked_amx_holder() override
 	{
 		amx_Cleanup(_amx);
-		delete[] _amx->base;
-		delete _amx;
+		templ->release(_amx);
 	}
 };
 
 struct forked_context : public amx::extra
 {
+	static constexpr amx::extra_slot slot = amx::extra_slot::forked_context;
+
 	bool cloned = false;
 
 	forked_context(AMX *amx) : amx::extra(amx)
@@ -53,6 +204,8 @@ struct forked_context : public amx::extra
 
 struct parallel_context : public amx::extra
 {
+	static constexpr amx::extra_slot slot = amx::extra_slot::parallel_context;
+
 	AMX_DEBUG old_debug = nullptr;
 	bool on_break = false;
 	int count = 0;
@@ -71,6 +224,13 @@ amx_code_info::amx_code_info(AMX *amx) : amx::extra(amx)
 	std::memcpy(code.get(), amx->base + amxhdr->cod, amxhdr->size - amxhdr->cod);
 }
 
+size_t fork_pool_stats(size_t &created, size_t &reused)
+{
+	created = fork_pool_created;
+	reused = fork_pool_reused;
+	return fork_pool_idle;
+}
+
 int AMXAPI amx_on_debug(AMX *amx)
 {
 	amx::object owner;
@@ -235,7 +395,9 @@ int AMXAPI amx_ExecContext(AMX *amx, cell *retval, int index, bool restore, amx:
 					{
 						if(retval != nullptr) *retval = info.result;
 						info.awaited_task = {};
-						task->register_reset(amx::reset(amx, true, info.restore_heap, info.restore_stack));
+						amx::reset reset(amx, true, info.restore_heap, info.restore_stack);
+						info.captured_size = reset.captured_size();
+						task->register_reset(std::move(reset));
 					}
 				}
 				break;
@@ -245,7 +407,9 @@ int AMXAPI amx_ExecContext(AMX *amx, cell *retval, int index, bool restore, amx:
 					amx->pri = 0;
 					amx->error = ret = AMX_ERR_NONE;
 					if(retval != nullptr) *retval = info.result;
-					tasks::register_tick(ticks, amx::reset(amx, true, info.restore_heap, info.restore_stack));
+					amx::reset reset(amx, true, info.restore_heap, info.restore_stack);
+					info.captured_size = reset.captured_size();
+					tasks::register_tick(ticks, std::move(reset));
 				}
 				break;
 				case SleepReturnWaitMs:
@@ -254,7 +418,9 @@ int AMXAPI amx_ExecContext(AMX *amx, cell *retval, int index, bool restore, amx:
 					amx->pri = 0;
 					amx->error = ret = AMX_ERR_NONE;
 					if(retval != nullptr) *retval = info.result;
-					tasks::register_timer(interval, amx::reset(amx, true, info.restore_heap, info.restore_stack));
+					amx::reset reset(amx, true, info.restore_heap, info.restore_stack);
+					info.captured_size = reset.captured_size();
+					tasks::register_timer(interval, std::move(reset));
 				}
 				break;
 				case SleepReturnWaitInf:
@@ -370,26 +536,33 @@ int AMXAPI amx_ExecContext(AMX *amx, cell *retval, int index, bool restore, amx:
 						}
 					}else if(method == 2)
 					{
-						AMX *amx_fork = new AMX();
-						auto lock = amx::clone_lock(amx, amx_fork);
-
-						auto code = owner->get_extra<amx_code_info>().code.get();
+						auto &templ = owner->get_extra<fork_template_extra>().templ;
+						if(!templ || !templ->matches(amx))
+						{
+							// forks do not have their own copy of the original code
+							const unsigned char *code = templ ? templ->code.get() : owner->get_extra<amx_code_info>().code.get();
+							auto new_templ = std::make_shared<fork_template>();
+							int initret = new_templ->init(amx, code);
+							if(initret != AMX_ERR_NONE)
+							{
+								logwarn(amx, "[PawnPlus] amx_fork: couldn't create the fork (error %d).", initret);
+								continue;
+							}
+							templ = std::move(new_templ);
+						}
 
-						amx_fork->base = new unsigned char[amxhdr->stp];
-						std::memcpy(amx_fork->base, amx->base, amxhdr->cod); // copy header
-						std::memcpy(amx_fork->base + amxhdr->cod, code, amxhdr->size - amxhdr->cod); // copy original code
-						int initret = amx_Init(amx_fork, amx_fork->base);
-						if(initret != AMX_ERR_NONE)
+						AMX *amx_fork = templ->acquire(!(flags & SleepReturnForkFlagsCopyData));
+						if(!amx_fork)
 						{
-							delete[] amx_fork->base;
-							delete amx_fork;
-							amx::unload(amx_fork);
-							logwarn(amx, "[PawnPlus] amx_fork: couldn't create the fork (error %d).", initret);
+							logwarn(amx, "[PawnPlus] amx_fork: couldn't create the fork (error %d).", AMX_ERR_MEMORY);
 							continue;
 						}
+						auto lock = amx::clone_lock(amx, amx_fork);
+						lock->get_extra<forked_amx_holder>().templ = templ;
+
 						if(flags & SleepReturnForkFlagsCopyData)
 						{
-							std::memcpy(amx_fork->base + amxhdr->dat, amx_GetData(amx), amxhdr->hea - amxhdr->dat); // copy the data
+							std::memcpy(amx_GetData(amx_fork), amx_GetData(amx), amxhdr->hea - amxhdr->dat); // copy the data
 						}
 
 						amx::reset reset(amx, false);
@@ -398,10 +571,7 @@ int AMXAPI amx_ExecContext(AMX *amx, cell *retval, int index, bool restore, amx:
 
 						amx_fork->pri = 1;
 						amx_fork->error = AMX_ERR_NONE;
-						amx_fork->callback = amx_Callback;
-						amx_fork->flags |= AMX_FLAG_NTVREG;
 
-						lock->get_extra<forked_amx_holder>();
 						cell *result, *error;
 						amx_GetAddr(amx, result_addr, &result);
 						amx_GetAddr(amx, error_addr, &error);
@@ -424,7 +594,7 @@ int AMXAPI amx_ExecContext(AMX *amx, cell *retval, int index, bool restore, amx:
 							}
 							if(flags & SleepReturnForkFlagsCopyData)
 							{
-								std::memcpy(amx_GetData(amx), amx_fork->base + amxhdr->dat, amxhdr->hea - amxhdr->dat);
+								std::memcpy(amx_GetData(amx), amx_GetData(amx_fork), amxhdr->hea - amxhdr->dat);
 							}
 						}
 					}
@@ -581,9 +751,10 @@ int AMXAPI amx_ExecContext(AMX *amx, cell *retval, int index, bool restore, amx:
 						{
 							cell num = list->size() * sizeof(cell);
 							amx->stk -= num + 2 * sizeof(cell);
+							dyn_object buffer;
 							for(cell i = list->size() - 1; i >= 0; i--)
 							{
-								cell val = (*list)[i].store(amx);
+								cell val = list->get(i, buffer).store(amx);
 								*--stk = val;
 							}
 							*--stk = num;
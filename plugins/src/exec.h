@@ -5,12 +5,18 @@
 #include "sdk/amx/amx.h"
 
 extern int maxRecursionLevel;
+// maximum number of finished forks kept for reuse by each script
+extern size_t fork_pool_size;
 
 int AMXAPI amx_ExecContext(AMX *amx, cell *retval, int index, bool restore, amx::reset *reset, bool forked = false);
+// returns the number of idle forks
+size_t fork_pool_stats(size_t &created, size_t &reused);
 
 // Holds the original code of the program (i.e. before relocation)
 struct amx_code_info : public amx::extra
 {
+	static constexpr amx::extra_slot slot = amx::extra_slot::code_info;
+
 	std::unique_ptr<unsigned char[]> code;
 
 	amx_code_info(AMX *amx);
@@ -7,11 +7,13 @@
 #include "modules/events.h"
 #include "modules/threads.h"
 #include "modules/strings.h"
+#include "modules/regex.h"
 #include "modules/variants.h"
 #include "modules/containers.h"
 #include "modules/tags.h"
 #include "modules/debug.h"
 #include "modules/expressions.h"
+#include "objects/reset.h"
 
 #include "sdk/amx/amx.h"
 #include "sdk/plugincommon.h"
@@ -64,6 +66,9 @@ PLUGIN_EXPORT void PLUGIN_CALL Unload() noexcept
 	iter_pool.clear();
 	tasks::clear();
 	strings::pool.clear();
+	sort_workers.resize(0);
+	amx::clear_snapshots();
+	Threads::StopWorkers();
 
 	Hooks::Unregister();
 
@@ -84,6 +89,7 @@ PLUGIN_EXPORT int PLUGIN_CALL AmxLoad(AMX *amx) noexcept
 PLUGIN_EXPORT int PLUGIN_CALL AmxUnload(AMX *amx) noexcept
 {
 	amx::invalidate(amx);
+	strings::regex_cache_release(amx);
 	amx::unload(amx);
 	return AMX_ERR_NONE;
 }
@@ -7,6 +7,8 @@
 
 struct fork_info_extra : public amx::extra
 {
+	static constexpr amx::extra_slot slot = amx::extra_slot::fork_info;
+
 	cell result_address = -1;
 	cell error_address = -1;
 
@@ -6,9 +6,108 @@ aux::shared_id_set_pool<linked_list_t> linked_list_pool;
 aux::shared_id_set_pool<pool_t> pool_pool;
 object_pool<dyn_iterator> iter_pool;
 object_pool<handle_t> handle_pool;
+aux::worker_pool sort_workers;
+size_t sort_parallel_threshold = 100000;
+
+bool is_plain_cell_tag(tag_ptr tag)
+{
+	switch(tag->uid)
+	{
+		case tags::tag_cell:
+		case tags::tag_bool:
+		case tags::tag_char:
+		case tags::tag_float:
+		case tags::tag_signed:
+		case tags::tag_unsigned:
+		case tags::tag_address:
+			return true;
+	}
+	return false;
+}
+
+bool has_bitwise_eq(tag_ptr tag)
+{
+	return is_plain_cell_tag(tag) && tag->uid != tags::tag_float;
+}
+
+bool list_t::can_store(const dyn_object &value) const
+{
+	if(!value.is_cell())
+	{
+		return false;
+	}
+	tag_ptr tag = value.get_tag();
+	return cell_tag != nullptr ? tag == cell_tag : is_plain_cell_tag(tag);
+}
+
+void list_t::expand()
+{
+	if(compact)
+	{
+		compact = false;
+		data.reserve(cells.capacity());
+		for(cell value : cells)
+		{
+			data.emplace_back(value, cell_tag);
+		}
+		std::vector<cell>().swap(cells);
+		cell_tag = nullptr;
+	}
+}
+
+void list_t::clear()
+{
+	if(!compact || cells.size() > 0)
+	{
+		data.clear();
+		cells.clear();
+		compact = true;
+		cell_tag = nullptr;
+		++revision;
+	}
+}
+
+void list_t::swap(list_t &other)
+{
+	collection_base::swap(other);
+	std::swap(compact, other.compact);
+	std::swap(cell_tag, other.cell_tag);
+	std::swap(cells, other.cells);
+}
+
+bool list_t::push_compact(const dyn_object &value)
+{
+	if(!can_store(value))
+	{
+		return false;
+	}
+	if(!compact)
+	{
+		if(data.size() > 0)
+		{
+			return false;
+		}
+		// a list that was emptied can be compact again
+		compact = true;
+		++revision;
+	}
+	bool invalidate = cells.size() == cells.capacity();
+	cell_tag = value.get_tag();
+	cells.push_back(value.get_cell(0));
+	if(invalidate)
+	{
+		++revision;
+	}
+	return true;
+}
 
 void list_t::push_back(dyn_object &&value)
 {
+	if(push_compact(value))
+	{
+		return;
+	}
+	expand();
 	bool invalidate = data.size() == data.capacity();
 	data.push_back(std::move(value));
 	if(invalidate)
@@ -19,6 +118,11 @@ void list_t::push_back(dyn_object &&value)
 
 void list_t::push_back(const dyn_object &value)
 {
+	if(push_compact(value))
+	{
+		return;
+	}
+	expand();
 	bool invalidate = data.size() == data.capacity();
 	data.push_back(value);
 	if(invalidate)
@@ -27,6 +131,17 @@ void list_t::push_back(const dyn_object &value)
 	}
 }
 
+void list_t::set(size_t index, dyn_object &&value)
+{
+	if(compact && can_store(value))
+	{
+		cells[index] = value.get_cell(0);
+		return;
+	}
+	expand();
+	data[index] = std::move(value);
+}
+
 auto list_t::insert(iterator position, dyn_object &&value) -> iterator
 {
 	bool invalidate = position == data.end() ? data.size() == data.capacity() : true;
@@ -49,6 +164,33 @@ auto list_t::insert(iterator position, const dyn_object &value) -> iterator
 	return it;
 }
 
+void list_t::insert(size_t index, dyn_object &&value)
+{
+	if(compact && can_store(value))
+	{
+		bool invalidate = index == cells.size() ? cells.size() == cells.capacity() : true;
+		cell_tag = value.get_tag();
+		cells.insert(cells.begin() + index, value.get_cell(0));
+		if(invalidate)
+		{
+			++revision;
+		}
+		return;
+	}
+	insert(begin() + index, std::move(value));
+}
+
+void list_t::erase(size_t first, size_t last)
+{
+	if(compact)
+	{
+		cells.erase(cells.begin() + first, cells.begin() + last);
+		++revision;
+		return;
+	}
+	erase(begin() + first, begin() + last);
+}
+
 bool list_t::insert_dyn(iterator position, const std::type_info &type, void *value, iterator &result)
 {
 	if(type == typeid(dyn_object))
@@ -71,8 +213,14 @@ bool list_t::insert_dyn(iterator position, const std::type_info &type, const voi
 
 void list_t::resize(size_t count)
 {
-	bool invalidate = count < data.size() || count > data.capacity();
-	data.resize(count);
+	bool invalidate = count < size() || count > capacity();
+	if(compact && count <= cells.size())
+	{
+		cells.resize(count);
+	}else{
+		expand();
+		data.resize(count);
+	}
 	if(invalidate)
 	{
 		++revision;
@@ -81,8 +229,18 @@ void list_t::resize(size_t count)
 
 void list_t::resize(size_t count, const dyn_object &value)
 {
-	bool invalidate = count < data.size() || count > data.capacity();
-	data.resize(count, value);
+	bool invalidate = count < size() || count > capacity();
+	if(compact && count <= cells.size())
+	{
+		cells.resize(count);
+	}else if(compact && can_store(value))
+	{
+		cell_tag = value.get_tag();
+		cells.resize(count, value.get_cell(0));
+	}else{
+		expand();
+		data.resize(count, value);
+	}
 	if(invalidate)
 	{
 		++revision;
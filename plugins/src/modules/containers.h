@@ -6,6 +6,7 @@
 #include "utils/shared_id_set_pool.h"
 #include "utils/hybrid_map.h"
 #include "utils/hybrid_pool.h"
+#include "utils/worker_pool.h"
 #include "fixes/linux.h"
 
 #include "sdk/amx/amx.h"
@@ -122,30 +123,118 @@ public:
 	}
 };
 
+// true for built-in cell tags, whose operations do not depend on any state
+bool is_plain_cell_tag(tag_ptr tag);
+// true for built-in cell tags whose values are equal only when their cells are
+bool has_bitwise_eq(tag_ptr tag);
+
 class list_t : public collection_base<std::vector<dyn_object>>
 {
+	// while all elements are scalars with the same plain tag, only their values are stored
+	bool compact = true;
+	tag_ptr cell_tag = nullptr;
+	std::vector<cell> cells;
+
+	bool can_store(const dyn_object &value) const;
+	// converts the list to the regular storage, needed before handing out references to the elements
+	void expand();
+	// adds the value as a cell if the list is or can become compact
+	bool push_compact(const dyn_object &value);
+
 public:
 	typedef typename std::vector<dyn_object>::reverse_iterator reverse_iterator;
+
+	iterator begin()
+	{
+		expand();
+		return data.begin();
+	}
+
+	iterator end()
+	{
+		expand();
+		return data.end();
+	}
+
+	// a compact list has no dyn_object instances to refer to; use get instead
+	const_iterator cbegin() const = delete;
+	const_iterator cend() const = delete;
+
 	reverse_iterator rbegin()
 	{
+		expand();
 		return data.rbegin();
 	}
 	reverse_iterator rend()
 	{
+		expand();
 		return data.rend();
 	}
 	dyn_object &operator[](size_t index)
 	{
+		expand();
 		return data[index];
 	}
-	const dyn_object &operator[](size_t index) const
+	const dyn_object &operator[](size_t index) const = delete;
+
+	// reads an element without changing the representation of the list;
+	// the element of a compact list is built in buffer
+	const dyn_object &get(size_t index, dyn_object &buffer) const
 	{
+		if(compact)
+		{
+			buffer = dyn_object(cells[index], cell_tag);
+			return buffer;
+		}
 		return data[index];
 	}
+
+	size_t size() const
+	{
+		return compact ? cells.size() : data.size();
+	}
+
+	void clear();
+	void swap(list_t &other);
+
+	std::vector<dyn_object> &get_data()
+	{
+		expand();
+		return collection_base::get_data();
+	}
+
+	const std::vector<dyn_object> &get_data() const = delete;
+
+	bool is_compact() const
+	{
+		return compact;
+	}
+
+	tag_ptr get_cell_tag() const
+	{
+		return cell_tag;
+	}
+
+	const std::vector<cell> &get_cells() const
+	{
+		return cells;
+	}
+
+	std::vector<cell> &get_cells()
+	{
+		++revision;
+		return cells;
+	}
+
 	void push_back(dyn_object &&value);
 	void push_back(const dyn_object &value);
+	void set(size_t index, dyn_object &&value);
 	iterator insert(iterator position, dyn_object &&value);
 	iterator insert(iterator position, const dyn_object &value);
+	// index-based versions that keep a compact list compact if the value can be stored in it
+	void insert(size_t index, dyn_object &&value);
+	void erase(size_t first, size_t last);
+	using collection_base::erase;
 	bool insert_dyn(iterator position, const std::type_info &type, void *value, iterator &result);
 	bool insert_dyn(iterator position, const std::type_info &type, const void *value, iterator &result);
 
@@ -161,16 +250,21 @@ public:
 
 	void reserve(size_t count)
 	{
-		if(count > data.capacity())
+		if(count > capacity())
 		{
 			++revision;
 		}
-		data.reserve(count);
+		if(compact)
+		{
+			cells.reserve(count);
+		}else{
+			data.reserve(count);
+		}
 	}
 
 	size_t capacity() const
 	{
-		return data.capacity();
+		return compact ? cells.capacity() : data.capacity();
 	}
 };
 
@@ -1064,4 +1158,8 @@ extern aux::shared_id_set_pool<pool_t> pool_pool;
 extern object_pool<dyn_iterator> iter_pool;
 extern object_pool<handle_t> handle_pool;
 
+// lists with at least sort_parallel_threshold elements are sorted using these threads
+extern aux::worker_pool sort_workers;
+extern size_t sort_parallel_threshold;
+
 #endif
@@ -126,6 +126,8 @@ public:
 class amx_info : public amx::extra
 {
 public:
+	static constexpr amx::extra_slot slot = amx::extra_slot::events;
+
 	std::vector<event_list> callback_handlers;
 	std::unordered_map<int, event_list> callback_handlers_negative;
 	std::unordered_map<cell, int> handler_ids;
@@ -0,0 +1,433 @@
+#include "expressions.h"
+#include "tags.h"
+#include "errors.h"
+
+#include <type_traits>
+
+void amx_ExpressionError(const char *format, ...);
+
+bool expression::compile(expression_compiler &, expression_operand &) const
+{
+	return false;
+}
+
+unsigned expression_compiler::alloc()
+{
+	unsigned index = top++;
+	if(top > prog.registers)
+	{
+		prog.registers = top;
+	}
+	return index;
+}
+
+void expression_compiler::release(const expression_operand &op)
+{
+	// registers are allocated as a stack, so operands must be released in reverse order
+	if(op.kind == expression_operand::reg && op.index + 1 == top)
+	{
+		top--;
+	}
+}
+
+expression_compiler::instruction &expression_compiler::emit(opcode op, unsigned dest)
+{
+	prog.code.emplace_back();
+	auto &ins = prog.code.back();
+	ins.op = op;
+	ins.dest = dest;
+	ins.a = ins.b = {expression_operand::reg, 0};
+	ins.target = 0;
+	return ins;
+}
+
+expression_operand expression_compiler::to_register(const expression_operand &op, unsigned dest)
+{
+	if(op.kind != expression_operand::reg || op.index != dest)
+	{
+		emit(opcode::move, dest).a = op;
+	}
+	return {expression_operand::reg, dest};
+}
+
+expression_operand expression_compiler::compile(const expression &expr)
+{
+	expression_operand result;
+	if(expr.compile(*this, result))
+	{
+		return result;
+	}
+	unsigned dest = alloc();
+	emit(opcode::tree, dest).tree = &expr;
+	return {expression_operand::reg, dest};
+}
+
+expression_operand expression_compiler::constant(const dyn_object &value)
+{
+	prog.constants.push_back(value);
+	return {expression_operand::constant, static_cast<unsigned>(prog.constants.size() - 1)};
+}
+
+expression_operand expression_compiler::arg(size_t index)
+{
+	return {expression_operand::arg, static_cast<unsigned>(index)};
+}
+
+expression_operand expression_compiler::unary(const expression &operand, unary_func func)
+{
+	auto a = compile(operand);
+	release(a);
+	unsigned dest = alloc();
+	auto &ins = emit(opcode::unary, dest);
+	ins.a = a;
+	ins.unary = func;
+	return {expression_operand::reg, dest};
+}
+
+expression_operand expression_compiler::binary(const expression &left, const expression &right, binary_func func)
+{
+	auto a = compile(left);
+	auto b = compile(right);
+	release(b);
+	release(a);
+	unsigned dest = alloc();
+	auto &ins = emit(opcode::binary, dest);
+	ins.a = a;
+	ins.b = b;
+	ins.binary = func;
+	return {expression_operand::reg, dest};
+}
+
+expression_operand expression_compiler::unary_logic(const expression &operand, unary_logic_func func)
+{
+	auto a = compile(operand);
+	release(a);
+	unsigned dest = alloc();
+	auto &ins = emit(opcode::unary_logic, dest);
+	ins.a = a;
+	ins.unary_logic = func;
+	return {expression_operand::reg, dest};
+}
+
+expression_operand expression_compiler::binary_logic(const expression &left, const expression &right, binary_logic_func func)
+{
+	auto a = compile(left);
+	auto b = compile(right);
+	release(b);
+	release(a);
+	unsigned dest = alloc();
+	auto &ins = emit(opcode::binary_logic, dest);
+	ins.a = a;
+	ins.b = b;
+	ins.binary_logic = func;
+	return {expression_operand::reg, dest};
+}
+
+expression_operand expression_compiler::logic(const expression &left, const expression &right, bool is_and)
+{
+	auto a = compile(left);
+	release(a);
+	unsigned dest = alloc();
+	emit(opcode::test, dest).a = a;
+	size_t jump = prog.code.size();
+	emit(is_and ? opcode::jump_unless : opcode::jump_if, dest).a = {expression_operand::reg, dest};
+	auto b = compile(right);
+	release(b);
+	emit(opcode::test, dest).a = b;
+	prog.code[jump].target = prog.code.size();
+	return {expression_operand::reg, dest};
+}
+
+expression_operand expression_compiler::cast(const expression &operand, tag_ptr tag)
+{
+	auto a = compile(operand);
+	release(a);
+	unsigned dest = alloc();
+	auto &ins = emit(opcode::cast, dest);
+	ins.a = a;
+	ins.tag = tag;
+	return {expression_operand::reg, dest};
+}
+
+expression_operand expression_compiler::conditional(const expression &cond, const expression &on_true, const expression &on_false)
+{
+	auto c = compile(cond);
+	release(c);
+	unsigned dest = alloc();
+	size_t jump_false = prog.code.size();
+	emit(opcode::jump_unless, dest).a = c;
+	auto t = compile(on_true);
+	release(t);
+	to_register(t, dest);
+	size_t jump_end = prog.code.size();
+	emit(opcode::jump, dest);
+	prog.code[jump_false].target = prog.code.size();
+	auto f = compile(on_false);
+	release(f);
+	to_register(f, dest);
+	prog.code[jump_end].target = prog.code.size();
+	return {expression_operand::reg, dest};
+}
+
+void expression_compiler::compile(const expression &expr, program &prog)
+{
+	expression_compiler compiler(prog);
+	prog.result = compiler.compile(expr);
+}
+
+bool constant_expression::compile(expression_compiler &compiler, expression_operand &result) const
+{
+	result = compiler.constant(value);
+	return true;
+}
+
+bool arg_expression::compile(expression_compiler &compiler, expression_operand &result) const
+{
+	result = compiler.arg(index);
+	return true;
+}
+
+bool nested_expression::compile(expression_compiler &compiler, expression_operand &result) const
+{
+	result = compiler.compile(*expr);
+	return true;
+}
+
+bool cast_expression::compile(expression_compiler &compiler, expression_operand &result) const
+{
+	result = compiler.cast(*operand, new_tag);
+	return true;
+}
+
+bool logic_and_expression::compile(expression_compiler &compiler, expression_operand &result) const
+{
+	result = compiler.logic(*left, *right, true);
+	return true;
+}
+
+bool logic_or_expression::compile(expression_compiler &compiler, expression_operand &result) const
+{
+	result = compiler.logic(*left, *right, false);
+	return true;
+}
+
+bool conditional_expression::compile(expression_compiler &compiler, expression_operand &result) const
+{
+	result = compiler.conditional(*cond, *on_true, *on_false);
+	return true;
+}
+
+// Registers are constructed in place, so small programs do not allocate.
+class register_file
+{
+	static constexpr unsigned inline_count = 8;
+
+	typename std::aligned_storage<sizeof(dyn_object), alignof(dyn_object)>::type inline_regs[inline_count];
+	std::vector<dyn_object> heap_regs;
+	dyn_object *regs;
+	unsigned count;
+
+public:
+	register_file(unsigned count) : count(count)
+	{
+		if(count <= inline_count)
+		{
+			regs = reinterpret_cast<dyn_object*>(inline_regs);
+			for(unsigned i = 0; i < count; i++)
+			{
+				new (&regs[i]) dyn_object();
+			}
+		}else{
+			heap_regs.resize(count);
+			regs = heap_regs.data();
+		}
+	}
+
+	register_file(const register_file&) = delete;
+	register_file &operator=(const register_file&) = delete;
+
+	~register_file()
+	{
+		if(count <= inline_count)
+		{
+			for(unsigned i = 0; i < count; i++)
+			{
+				regs[i].~dyn_object();
+			}
+		}
+	}
+
+	dyn_object &operator[](unsigned index)
+	{
+		return regs[index];
+	}
+};
+
+dyn_object compiled_expression::run(const args_type &args, const exec_info &info) const
+{
+	register_file regs(code.registers);
+
+	auto get = [&](const expression_operand &op) -> const dyn_object&
+	{
+		switch(op.kind)
+		{
+			case expression_operand::reg:
+				return regs[op.index];
+			case expression_operand::constant:
+				return code.constants[op.index];
+			default:
+				if(op.index >= args.size())
+				{
+					amx_ExpressionError("expression argument #%d was not provided", op.index);
+				}
+				return args[op.index].get();
+		}
+	};
+
+	const auto &ops = code.code;
+	size_t size = ops.size();
+	size_t ip = 0;
+	while(ip < size)
+	{
+		const auto &ins = ops[ip++];
+		switch(ins.op)
+		{
+			case expression_compiler::opcode::move:
+				if(ins.a.kind == expression_operand::reg)
+				{
+					regs[ins.dest] = std::move(regs[ins.a.index]);
+				}else{
+					regs[ins.dest] = get(ins.a);
+				}
+				break;
+			case expression_compiler::opcode::unary:
+				regs[ins.dest] = (get(ins.a).*ins.unary)();
+				break;
+			case expression_compiler::opcode::binary:
+				regs[ins.dest] = (get(ins.a).*ins.binary)(get(ins.b));
+				break;
+			case expression_compiler::opcode::unary_logic:
+				regs[ins.dest] = dyn_object((get(ins.a).*ins.unary_logic)(), tags::find_tag(tags::tag_bool));
+				break;
+			case expression_compiler::opcode::binary_logic:
+				regs[ins.dest] = dyn_object((get(ins.a).*ins.binary_logic)(get(ins.b)), tags::find_tag(tags::tag_bool));
+				break;
+			case expression_compiler::opcode::test:
+				regs[ins.dest] = dyn_object(!!get(ins.a), tags::find_tag(tags::tag_bool));
+				break;
+			case expression_compiler::opcode::cast:
+				regs[ins.dest] = dyn_object(get(ins.a), ins.tag);
+				break;
+			case expression_compiler::opcode::jump:
+				ip = ins.target;
+				break;
+			case expression_compiler::opcode::jump_if:
+				if(!!get(ins.a))
+				{
+					ip = ins.target;
+				}
+				break;
+			case expression_compiler::opcode::jump_unless:
+				if(!get(ins.a))
+				{
+					ip = ins.target;
+				}
+				break;
+			case expression_compiler::opcode::tree:
+				regs[ins.dest] = ins.tree->execute(args, info);
+				break;
+		}
+	}
+
+	if(code.result.kind == expression_operand::reg)
+	{
+		return std::move(regs[code.result.index]);
+	}
+	return get(code.result);
+}
+
+dyn_object compiled_expression::execute(const args_type &args, const exec_info &info) const
+{
+	return run(args, info);
+}
+
+void compiled_expression::execute_discard(const args_type &args, const exec_info &info) const
+{
+	// the program only computes the value, which may raise errors that discarding avoids
+	expr->execute_discard(args, info);
+}
+
+void compiled_expression::execute_multi(const args_type &args, const exec_info &info, call_args_type &output) const
+{
+	if(expr->get_count(args) == 1)
+	{
+		output.push_back(run(args, info));
+	}else{
+		expr->execute_multi(args, info, output);
+	}
+}
+
+dyn_object compiled_expression::call(const args_type &args, const exec_info &info, const call_args_type &call_args) const
+{
+	return expr->call(args, info, call_args);
+}
+
+void compiled_expression::call_discard(const args_type &args, const exec_info &info, const call_args_type &call_args) const
+{
+	expr->call_discard(args, info, call_args);
+}
+
+void compiled_expression::call_multi(const args_type &args, const exec_info &info, const call_args_type &call_args, call_args_type &output) const
+{
+	expr->call_multi(args, info, call_args, output);
+}
+
+dyn_object compiled_expression::assign(const args_type &args, const exec_info &info, dyn_object &&value) const
+{
+	return expr->assign(args, info, std::move(value));
+}
+
+dyn_object compiled_expression::index(const args_type &args, const exec_info &info, const call_args_type &indices) const
+{
+	return expr->index(args, info, indices);
+}
+
+dyn_object compiled_expression::index_assign(const args_type &args, const exec_info &info, const call_args_type &indices, dyn_object &&value) const
+{
+	return expr->index_assign(args, info, indices, std::move(value));
+}
+
+std::tuple<cell*, size_t, tag_ptr> compiled_expression::address(const args_type &args, const exec_info &info, const call_args_type &indices) const
+{
+	return expr->address(args, info, indices);
+}
+
+tag_ptr compiled_expression::get_tag(const args_type &args) const noexcept
+{
+	return expr->get_tag(args);
+}
+
+cell compiled_expression::get_size(const args_type &args) const noexcept
+{
+	return expr->get_size(args);
+}
+
+cell compiled_expression::get_rank(const args_type &args) const noexcept
+{
+	return expr->get_rank(args);
+}
+
+cell compiled_expression::get_count(const args_type &args) const noexcept
+{
+	return expr->get_count(args);
+}
+
+void compiled_expression::to_string(strings::cell_string &str) const noexcept
+{
+	expr->to_string(str);
+}
+
+decltype(expression_pool)::object_ptr compiled_expression::clone() const
+{
+	return expression_pool.emplace_derived<compiled_expression>(*this);
+}
@@ -17,6 +17,19 @@
 
 typedef std::shared_ptr<const class expression> expression_ptr;
 
+class expression_compiler;
+
+struct expression_operand
+{
+	enum kind_type : unsigned char
+	{
+		reg, constant, arg
+	};
+
+	kind_type kind;
+	unsigned index;
+};
+
 class expression
 {
 public:
@@ -82,6 +95,8 @@ public:
 	virtual cell get_rank(const args_type &args) const noexcept;
 	virtual cell get_count(const args_type &args) const noexcept;
 	virtual void to_string(strings::cell_string &str) const noexcept = 0;
+	// returns false if the node has to be executed by walking the tree
+	virtual bool compile(expression_compiler &compiler, expression_operand &result) const;
 
 	virtual ~expression() = default;
 	int &operator[](size_t index) const;
@@ -90,6 +105,76 @@ protected:
 	void checkstack() const;
 };
 
+// Lowers an expression tree to instructions operating on a register file.
+// Values are read directly from constants and arguments, so only results of operations occupy registers.
+class expression_compiler
+{
+public:
+	typedef dyn_object(dyn_object::*unary_func)() const;
+	typedef dyn_object(dyn_object::*binary_func)(const dyn_object&) const;
+	typedef bool(dyn_object::*unary_logic_func)() const;
+	typedef bool(dyn_object::*binary_logic_func)(const dyn_object&) const;
+
+	enum class opcode : unsigned char
+	{
+		move, unary, binary, unary_logic, binary_logic, test, cast, jump, jump_if, jump_unless, tree
+	};
+
+	struct instruction
+	{
+		opcode op;
+		unsigned dest;
+		expression_operand a;
+		expression_operand b;
+		union
+		{
+			unary_func unary;
+			binary_func binary;
+			unary_logic_func unary_logic;
+			binary_logic_func binary_logic;
+			tag_ptr tag;
+			size_t target;
+			const expression *tree;
+		};
+	};
+
+	struct program
+	{
+		std::vector<instruction> code;
+		std::vector<dyn_object> constants;
+		expression_operand result;
+		unsigned registers = 0;
+	};
+
+private:
+	program &prog;
+	unsigned top = 0;
+
+	unsigned alloc();
+	void release(const expression_operand &op);
+	instruction &emit(opcode op, unsigned dest);
+	expression_operand to_register(const expression_operand &op, unsigned dest);
+
+public:
+	expression_compiler(program &prog) : prog(prog)
+	{
+
+	}
+
+	expression_operand compile(const expression &expr);
+	expression_operand constant(const dyn_object &value);
+	expression_operand arg(size_t index);
+	expression_operand unary(const expression &operand, unary_func func);
+	expression_operand binary(const expression &left, const expression &right, binary_func func);
+	expression_operand unary_logic(const expression &operand, unary_logic_func func);
+	expression_operand binary_logic(const expression &left, const expression &right, binary_logic_func func);
+	expression_operand logic(const expression &left, const expression &right, bool is_and);
+	expression_operand cast(const expression &operand, tag_ptr tag);
+	expression_operand conditional(const expression &cond, const expression &on_true, const expression &on_false);
+
+	static void compile(const expression &expr, program &prog);
+};
+
 extern object_pool<expression> expression_pool;
 
 class expression_base : public expression, public object_pool<expression>::ref_container_virtual
@@ -133,6 +218,7 @@ public:
 	virtual cell get_rank(const args_type &args) const noexcept override;
 	virtual cell get_count(const args_type &args) const noexcept override;
 	virtual void to_string(strings::cell_string &str) const noexcept override;
+	virtual bool compile(expression_compiler &compiler, expression_operand &result) const override;
 	virtual decltype(expression_pool)::object_ptr clone() const override;
 
 	virtual const dyn_object &get_value() const override
@@ -238,6 +324,7 @@ public:
 	virtual cell get_rank(const args_type &args) const noexcept override;
 	virtual cell get_count(const args_type &args) const noexcept override;
 	virtual void to_string(strings::cell_string &str) const noexcept override;
+	virtual bool compile(expression_compiler &compiler, expression_operand &result) const override;
 	virtual decltype(expression_pool)::object_ptr clone() const override;
 
 protected:
@@ -387,6 +474,7 @@ public:
 	virtual cell get_rank(const args_type &args) const noexcept override;
 	virtual cell get_count(const args_type &args) const noexcept override;
 	virtual void to_string(strings::cell_string &str) const noexcept override;
+	virtual bool compile(expression_compiler &compiler, expression_operand &result) const override;
 	virtual const expression_ptr &get_operand() const noexcept override;
 	virtual decltype(expression_pool)::object_ptr clone() const override;
 };
@@ -712,6 +800,7 @@ public:
 	virtual cell get_rank(const args_type &args) const noexcept override;
 	virtual cell get_count(const args_type &args) const noexcept override;
 	virtual void to_string(strings::cell_string &str) const noexcept override;
+	virtual bool compile(expression_compiler &compiler, expression_operand &result) const override;
 	virtual const expression_ptr &get_operand() const noexcept override;
 	virtual decltype(expression_pool)::object_ptr clone() const override;
 };
@@ -986,6 +1075,12 @@ public:
 		return operand;
 	}
 
+	virtual bool compile(expression_compiler &compiler, expression_operand &result) const override
+	{
+		result = compiler.unary(*operand, Func);
+		return true;
+	}
+
 	virtual decltype(expression_pool)::object_ptr clone() const override
 	{
 		return expression_pool.emplace_derived<unary_object_expression<Func>>(*this);
@@ -1151,6 +1246,12 @@ public:
 		return right;
 	}
 
+	virtual bool compile(expression_compiler &compiler, expression_operand &result) const override
+	{
+		result = compiler.binary(*left, *right, Func);
+		return true;
+	}
+
 	virtual decltype(expression_pool)::object_ptr clone() const override
 	{
 		return expression_pool.emplace_derived<binary_object_expression<Func>>(*this);
@@ -1273,6 +1374,12 @@ public:
 		str.append(strings::convert(Value ? "true" : "false"));
 	}
 
+	virtual bool compile(expression_compiler &compiler, expression_operand &result) const override
+	{
+		result = compiler.constant(dyn_object(Value, tags::find_tag(tags::tag_bool)));
+		return true;
+	}
+
 	virtual decltype(expression_pool)::object_ptr clone() const override
 	{
 		return expression_pool.emplace_derived<const_bool_expression<Value>>(*this);
@@ -1327,6 +1434,12 @@ public:
 		return operand;
 	}
 
+	virtual bool compile(expression_compiler &compiler, expression_operand &result) const override
+	{
+		result = compiler.unary_logic(*operand, Func);
+		return true;
+	}
+
 	virtual decltype(expression_pool)::object_ptr clone() const override
 	{
 		return expression_pool.emplace_derived<unary_logic_expression<Func>>(*this);
@@ -1440,6 +1553,12 @@ public:
 		return right;
 	}
 
+	virtual bool compile(expression_compiler &compiler, expression_operand &result) const override
+	{
+		result = compiler.binary_logic(*left, *right, Func);
+		return true;
+	}
+
 	virtual decltype(expression_pool)::object_ptr clone() const override
 	{
 		return expression_pool.emplace_derived<binary_logic_expression<Func>>(*this);
@@ -1464,6 +1583,7 @@ public:
 
 	virtual bool execute_inner(const args_type &args, const exec_info &info) const override;
 	virtual void to_string(strings::cell_string &str) const noexcept override;
+	virtual bool compile(expression_compiler &compiler, expression_operand &result) const override;
 	virtual const expression_ptr &get_left() const noexcept override;
 	virtual const expression_ptr &get_right() const noexcept override;
 	virtual decltype(expression_pool)::object_ptr clone() const override;
@@ -1487,6 +1607,7 @@ public:
 
 	virtual bool execute_inner(const args_type &args, const exec_info &info) const override;
 	virtual void to_string(strings::cell_string &str) const noexcept override;
+	virtual bool compile(expression_compiler &compiler, expression_operand &result) const override;
 	virtual const expression_ptr &get_left() const noexcept override;
 	virtual const expression_ptr &get_right() const noexcept override;
 	virtual decltype(expression_pool)::object_ptr clone() const override;
@@ -1524,6 +1645,7 @@ public:
 	virtual cell get_rank(const args_type &args) const noexcept override;
 	virtual cell get_count(const args_type &args) const noexcept override;
 	virtual void to_string(strings::cell_string &str) const noexcept override;
+	virtual bool compile(expression_compiler &compiler, expression_operand &result) const override;
 	virtual const expression_ptr &get_operand() const noexcept;
 	virtual const expression_ptr &get_left() const noexcept;
 	virtual const expression_ptr &get_right() const noexcept;
@@ -1776,4 +1898,41 @@ public:
 	virtual decltype(expression_pool)::object_ptr clone() const override;
 };
 
+// Expression executed from code produced by expression_compiler, falling back to the original tree for other operations.
+class compiled_expression : public proxy_expression
+{
+	expression_ptr expr;
+	expression_compiler::program code;
+
+	dyn_object run(const args_type &args, const exec_info &info) const;
+
+public:
+	compiled_expression(expression_ptr &&expr) : expr(std::move(expr))
+	{
+		expression_compiler::compile(*this->expr, code);
+	}
+
+	compiled_expression(const expression_ptr &expr) : expr(expr)
+	{
+		expression_compiler::compile(*this->expr, code);
+	}
+
+	virtual dyn_object execute(const args_type &args, const exec_info &info) const override;
+	virtual void execute_discard(const args_type &args, const exec_info &info) const override;
+	virtual void execute_multi(const args_type &args, const exec_info &info, call_args_type &output) const override;
+	virtual dyn_object call(const args_type &args, const exec_info &info, const call_args_type &call_args) const override;
+	virtual void call_discard(const args_type &args, const exec_info &info, const call_args_type &call_args) const override;
+	virtual void call_multi(const args_type &args, const exec_info &info, const call_args_type &call_args, call_args_type &output) const override;
+	virtual dyn_object assign(const args_type &args, const exec_info &info, dyn_object &&value) const override;
+	virtual dyn_object index(const args_type &args, const exec_info &info, const call_args_type &indices) const override;
+	virtual dyn_object index_assign(const args_type &args, const exec_info &info, const call_args_type &indices, dyn_object &&value) const override;
+	virtual std::tuple<cell*, size_t, tag_ptr> address(const args_type &args, const exec_info &info, const call_args_type &indices) const override;
+	virtual tag_ptr get_tag(const args_type &args) const noexcept override;
+	virtual cell get_size(const args_type &args) const noexcept override;
+	virtual cell get_rank(const args_type &args) const noexcept override;
+	virtual cell get_count(const args_type &args) const noexcept override;
+	virtual void to_string(strings::cell_string &str) const noexcept override;
+	virtual decltype(expression_pool)::object_ptr clone() const override;
+};
+
 #endif
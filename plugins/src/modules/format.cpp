@@ -2,11 +2,17 @@
 #include "errors.h"
 #include "modules/parser.h"
 #include "modules/variants.h"
+#include "amxinfo.h"
 
 #include <cctype>
 #include <sstream>
 #include <bitset>
 #include <iomanip>
+#include <unordered_map>
+#include <list>
+#include <cstring>
+#include <cmath>
+#include <cstdint>
 
 using namespace strings;
 
@@ -35,6 +41,290 @@ namespace aux
 		ostream << std::forward<Obj>(obj);
 		return ostream.str();
 	}
+
+	// Numbers are formatted like by a stream in the classic locale, but without creating one.
+	template <class Unsigned>
+	char *write_unsigned(char *end, Unsigned value, unsigned base)
+	{
+		static const char digits[] = "0123456789ABCDEF";
+		do{
+			*--end = digits[value % base];
+			value /= base;
+		}while(value != 0);
+		return end;
+	}
+
+	void append_padded(cell_string &buf, const char *begin, const char *end, cell width, char padding)
+	{
+		auto size = end - begin;
+		if(width > size)
+		{
+			buf.append(width - size, static_cast<unsigned char>(padding));
+		}
+		for(; begin != end; ++begin)
+		{
+			buf.push_back(static_cast<unsigned char>(*begin));
+		}
+	}
+
+	void append_integer(cell_string &buf, cell value, char type, cell width, char padding)
+	{
+		if(!numbers_classic())
+		{
+			switch(type)
+			{
+				case 'u':
+					buf.append(convert(to_string(static_cast<ucell>(value), std::setw(width), std::setfill(padding))));
+					break;
+				case 'x':
+					buf.append(convert(to_string(value, std::hex, std::uppercase, std::setw(width), std::setfill(padding))));
+					break;
+				case 'o':
+					buf.append(convert(to_string(value, std::oct, std::setw(width), std::setfill(padding))));
+					break;
+				default:
+					buf.append(convert(to_string(value, std::setw(width), std::setfill(padding))));
+					break;
+			}
+			return;
+		}
+		char str[sizeof(cell) * 3 + 2];
+		char *end = std::end(str);
+		char *begin;
+		switch(type)
+		{
+			case 'u':
+				begin = write_unsigned(end, static_cast<ucell>(value), 10);
+				break;
+			case 'x':
+				begin = write_unsigned(end, static_cast<ucell>(value), 16);
+				break;
+			case 'o':
+				begin = write_unsigned(end, static_cast<ucell>(value), 8);
+				break;
+			default:
+				if(value < 0)
+				{
+					begin = write_unsigned(end, 0 - static_cast<ucell>(value), 10);
+					*--begin = '-';
+				}else{
+					begin = write_unsigned(end, static_cast<ucell>(value), 10);
+				}
+				break;
+		}
+		append_padded(buf, begin, end, width, padding);
+	}
+
+	// exact decimal expansion of a float, as digits d1 d2 ... dn with value 0.d1d2...dn * 10^point.
+	struct decimal
+	{
+		std::string digits;
+		int point = 0;
+	};
+
+	decimal expand(float value)
+	{
+		std::uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		std::uint32_t mantissa = bits & 0x7FFFFF;
+		int exponent = (bits >> 23) & 0xFF;
+		if(exponent == 0)
+		{
+			exponent = -149;
+		}else{
+			mantissa |= 0x800000;
+			exponent -= 150;
+		}
+
+		decimal result;
+		if(mantissa == 0)
+		{
+			return result;
+		}
+
+		// mantissa * 2^exponent is an integer times 2^exponent or 5^-exponent, divided by 10^-exponent
+		std::vector<std::uint32_t> limbs(1, mantissa);
+		auto multiply = [&](std::uint32_t factor)
+		{
+			std::uint64_t carry = 0;
+			for(auto &limb : limbs)
+			{
+				std::uint64_t product = static_cast<std::uint64_t>(limb) * factor + carry;
+				limb = static_cast<std::uint32_t>(product % 1000000000);
+				carry = product / 1000000000;
+			}
+			while(carry != 0)
+			{
+				limbs.push_back(static_cast<std::uint32_t>(carry % 1000000000));
+				carry /= 1000000000;
+			}
+		};
+		if(limbs[0] >= 1000000000)
+		{
+			limbs[0] = mantissa % 1000000000;
+			limbs.push_back(mantissa / 1000000000);
+		}
+		int shift = exponent;
+		while(shift > 0)
+		{
+			int step = shift < 29 ? shift : 29;
+			multiply(static_cast<std::uint32_t>(1) << step);
+			shift -= step;
+		}
+		while(shift < 0)
+		{
+			int step = -shift < 13 ? -shift : 13;
+			std::uint32_t factor = 1;
+			for(int i = 0; i < step; i++)
+			{
+				factor *= 5;
+			}
+			multiply(factor);
+			shift += step;
+		}
+
+		char str[10];
+		for(auto it = limbs.rbegin(); it != limbs.rend(); ++it)
+		{
+			char *begin = write_unsigned(std::end(str), *it, 10);
+			if(it != limbs.rbegin())
+			{
+				result.digits.append(9 - (std::end(str) - begin), '0');
+			}
+			result.digits.append(begin, std::end(str));
+		}
+		result.point = static_cast<int>(result.digits.size()) + (exponent < 0 ? exponent : 0);
+		size_t last = result.digits.find_last_not_of('0');
+		result.digits.resize(last + 1);
+		return result;
+	}
+
+	// keeps the first count digits, rounding half to even like printf
+	void round_digits(decimal &dec, int count)
+	{
+		if(count >= static_cast<int>(dec.digits.size()))
+		{
+			return;
+		}
+		if(count < 0)
+		{
+			dec.digits.clear();
+			return;
+		}
+		char next = dec.digits[count];
+		bool up = next > '5' || (next == '5' && (static_cast<int>(dec.digits.size()) > count + 1 || (count > 0 && (dec.digits[count - 1] - '0') % 2 == 1)));
+		dec.digits.resize(count);
+		if(up)
+		{
+			int i = count - 1;
+			while(i >= 0 && dec.digits[i] == '9')
+			{
+				dec.digits[i] = '0';
+				i--;
+			}
+			if(i >= 0)
+			{
+				dec.digits[i]++;
+			}else{
+				dec.digits.insert(dec.digits.begin(), '1');
+				dec.point++;
+			}
+		}
+		size_t last = dec.digits.find_last_not_of('0');
+		dec.digits.resize(last == std::string::npos ? 0 : last + 1);
+	}
+
+	void write_fixed(std::string &str, const decimal &dec, int precision)
+	{
+		if(dec.point <= 0)
+		{
+			str.push_back('0');
+		}else{
+			for(int i = 0; i < dec.point; i++)
+			{
+				str.push_back(i < static_cast<int>(dec.digits.size()) ? dec.digits[i] : '0');
+			}
+		}
+		if(precision > 0)
+		{
+			str.push_back('.');
+			for(int i = dec.point; i < dec.point + precision; i++)
+			{
+				str.push_back(i >= 0 && i < static_cast<int>(dec.digits.size()) ? dec.digits[i] : '0');
+			}
+		}
+	}
+
+	void append_float(cell_string &buf, float value, cell precision, bool fixed, cell width, char padding)
+	{
+		if(!numbers_classic())
+		{
+			if(fixed)
+			{
+				buf.append(convert(to_string(value, std::setw(width), std::setfill(padding), std::setprecision(precision), std::fixed)));
+			}else{
+				buf.append(convert(to_string(value, std::setw(width), std::setfill(padding), std::setprecision(precision), std::defaultfloat)));
+			}
+			return;
+		}
+		std::string str;
+		if(std::signbit(value))
+		{
+			str.push_back('-');
+		}
+		if(std::isnan(value))
+		{
+			str.append("nan");
+		}else if(std::isinf(value))
+		{
+			str.append("inf");
+		}else{
+			decimal dec = expand(value);
+			if(fixed)
+			{
+				round_digits(dec, dec.point + precision);
+				write_fixed(str, dec, precision);
+			}else{
+				if(precision == 0)
+				{
+					precision = 1;
+				}
+				round_digits(dec, precision);
+				int exponent = dec.digits.empty() ? 0 : dec.point - 1;
+				size_t start = str.size();
+				if(exponent < precision && exponent >= -4)
+				{
+					write_fixed(str, dec, precision - 1 - exponent);
+				}else{
+					decimal mantissa = dec;
+					mantissa.point = 1;
+					write_fixed(str, mantissa, precision - 1);
+				}
+				// no trailing zeros without showpoint
+				if(str.find('.', start) != std::string::npos)
+				{
+					str.resize(str.find_last_not_of('0') + 1);
+					if(str.back() == '.')
+					{
+						str.pop_back();
+					}
+				}
+				if(!(exponent < precision && exponent >= -4))
+				{
+					str.push_back('e');
+					str.push_back(exponent < 0 ? '-' : '+');
+					char exp[8];
+					char *begin = write_unsigned(std::end(exp), static_cast<unsigned>(exponent < 0 ? -exponent : exponent), 10);
+					if(std::end(exp) - begin < 2)
+					{
+						str.push_back('0');
+					}
+					str.append(begin, std::end(exp));
+				}
+			}
+		}
+		append_padded(buf, str.data(), str.data() + str.size(), width, padding);
+	}
 }
 
 template <class Iter>
@@ -335,18 +625,17 @@ struct format_base
 					cell width = parse_num(begin, end);
 					if(begin == end && width > 0)
 					{
-						buf.append(convert(aux::to_string(*arg, std::setw(width), std::setfill(padding))));
+						aux::append_integer(buf, *arg, 'd', width, padding);
 						return;
 					}
 				}else{
-					buf.append(convert(aux::to_string(*arg)));
+					aux::append_integer(buf, *arg, 'd', 0, ' ');
 					return;
 				}
 			}
 			break;
 			case 'u':
 			{
-				ucell val = static_cast<ucell>(*arg);
 				if(begin != end)
 				{
 					char padding = static_cast<ucell>(*begin);
@@ -354,11 +643,11 @@ struct format_base
 					cell width = parse_num(begin, end);
 					if(begin == end && width > 0)
 					{
-						buf.append(convert(aux::to_string(val, std::setw(width), std::setfill(padding))));
+						aux::append_integer(buf, *arg, 'u', width, padding);
 						return;
 					}
 				}else{
-					buf.append(convert(aux::to_string(val)));
+					aux::append_integer(buf, *arg, 'u', 0, ' ');
 					return;
 				}
 			}
@@ -373,11 +662,11 @@ struct format_base
 					cell width = parse_num(begin, end);
 					if(begin == end && width > 0)
 					{
-						buf.append(convert(aux::to_string(*arg, std::hex, std::uppercase, std::setw(width), std::setfill(padding))));
+						aux::append_integer(buf, *arg, 'x', width, padding);
 						return;
 					}
 				}else{
-					buf.append(convert(aux::to_string(*arg, std::hex, std::uppercase)));
+					aux::append_integer(buf, *arg, 'x', 0, ' ');
 					return;
 				}
 			}
@@ -391,11 +680,11 @@ struct format_base
 					cell width = parse_num(begin, end);
 					if(begin == end && width > 0)
 					{
-						buf.append(convert(aux::to_string(*arg, std::oct, std::setw(width), std::setfill(padding))));
+						aux::append_integer(buf, *arg, 'o', width, padding);
 						return;
 					}
 				}else{
-					buf.append(convert(aux::to_string(*arg, std::oct)));
+					aux::append_integer(buf, *arg, 'o', 0, ' ');
 					return;
 				}
 			}
@@ -411,15 +700,15 @@ struct format_base
 					{
 						if(precision >= 0)
 						{
-							buf.append(convert(aux::to_string(val, std::setprecision(precision), std::fixed)));
+							aux::append_float(buf, val, precision, true, 0, ' ');
 						}else{
-							buf.append(convert(aux::to_string(val, std::setprecision(-precision), std::defaultfloat)));
+							aux::append_float(buf, val, -precision, false, 0, ' ');
 						}
 						return;
 					}
 				}else if(begin == end)
 				{
-					buf.append(convert(aux::to_string(val)));
+					aux::append_float(buf, val, 6, false, 0, ' ');
 					return;
 				}else{
 					char padding = static_cast<ucell>(*begin);
@@ -431,7 +720,7 @@ struct format_base
 					}
 					if(begin == end)
 					{
-						buf.append(convert(aux::to_string(val, std::setw(width), std::setfill(padding))));
+						aux::append_float(buf, val, 6, false, width, padding);
 						return;
 					}else if(*begin == '.')
 					{
@@ -441,9 +730,9 @@ struct format_base
 						{
 							if(precision >= 0)
 							{
-								buf.append(convert(aux::to_string(val, std::setw(width), std::setfill(padding), std::setprecision(precision), std::fixed)));
+								aux::append_float(buf, val, precision, true, width, padding);
 							}else{
-								buf.append(convert(aux::to_string(val, std::setw(width), std::setfill(padding), std::setprecision(-precision), std::defaultfloat)));
+								aux::append_float(buf, val, -precision, false, width, padding);
 							}
 							return;
 						}
@@ -706,12 +995,479 @@ struct format_base
 	}
 };
 
-void strings::format(AMX *amx, strings::cell_string &buf, const cell *format, cell argc, cell *args)
+class strings::format_program
+{
+public:
+	enum class op_type
+	{
+		text, percent, brace, expression
+	};
+
+	struct op
+	{
+		op_type type;
+		// range in literals for text, otherwise the parameters of the specifier in text
+		size_t begin;
+		size_t end;
+		cell spec;
+		// the argument index is parsed from [index_begin, index_stop), or is index when not dynamic
+		bool has_index;
+		bool dynamic;
+		cell index;
+		size_t index_begin;
+		size_t index_stop;
+		// after '$' in a % specifier
+		size_t index_end;
+		expression_ptr expr;
+	};
+
+	cell_string text;
+	cell_string literals;
+	std::vector<op> ops;
+	size_t num_specs = 0;
+};
+
+// Finds where parse_num would stop, and whether the value depends on the arguments.
+template <class Iter>
+static Iter skip_num(Iter begin, Iter end, bool &dynamic)
+{
+	if(begin == end)
+	{
+		return begin;
+	}
+	switch(*begin)
+	{
+		case '^':
+		case '*':
+		{
+			dynamic = true;
+			++begin;
+			return begin;
+		}
+		break;
+		case '@':
+		case '-':
+		{
+			dynamic = true;
+			++begin;
+			return skip_num(begin, end, dynamic);
+		}
+		break;
+	}
+	while(begin != end && std::isdigit(*begin))
+	{
+		++begin;
+	}
+	return begin;
+}
+
+template <class Iter>
+static cell static_num(Iter begin, Iter end)
+{
+	cell val = 0;
+	for(; begin != end; ++begin)
+	{
+		val = (val * 10) + (*begin - '0');
+	}
+	return val;
+}
+
+static std::unique_ptr<format_program> compile_format(AMX *amx, cell_string &&text)
+{
+	typedef cell_string::const_iterator Iter;
+	typedef format_program::op_type op_type;
+
+	std::unique_ptr<format_program> program(new format_program());
+	program->text = std::move(text);
+	auto &ops = program->ops;
+	Iter format_begin = program->text.cbegin();
+	Iter format_end = program->text.cend();
+	Iter start = format_begin;
+
+	auto offset = [&](Iter it)
+	{
+		return static_cast<size_t>(it - start);
+	};
+	auto add_text = [&](Iter begin, Iter end)
+	{
+		if(begin == end)
+		{
+			return;
+		}
+		auto &literals = program->literals;
+		size_t pos = literals.size();
+		literals.append(begin, end);
+		if(!ops.empty() && ops.back().type == op_type::text && ops.back().end == pos)
+		{
+			ops.back().end = literals.size();
+		}else{
+			format_program::op op{};
+			op.type = op_type::text;
+			op.begin = pos;
+			op.end = literals.size();
+			ops.push_back(std::move(op));
+		}
+	};
+
+	// mirrors format_base::operator(), but only records what should be done with the arguments
+	auto last = format_begin;
+	while(format_begin != format_end)
+	{
+		if(*format_begin == '%')
+		{
+			add_text(last, format_begin);
+
+			++format_begin;
+			if(format_begin == format_end)
+			{
+				amx_FormalError(errors::invalid_format, "unexpected end");
+			}
+
+			if(*format_begin == '%' || *format_begin == '{' || *format_begin == '}')
+			{
+				add_text(format_begin, std::next(format_begin));
+			}else{
+				last = format_begin;
+				bool pos_found = false;
+				Iter pos_end = format_begin;
+				while(format_begin != format_end && !std::isalpha(*format_begin))
+				{
+					if(*format_begin == '$')
+					{
+						pos_found = true;
+						pos_end = format_begin;
+					}
+					++format_begin;
+				}
+				if(format_begin == format_end)
+				{
+					amx_FormalError(errors::invalid_format, "unexpected end");
+				}
+				format_program::op op{};
+				op.type = op_type::percent;
+				op.spec = *format_begin;
+				op.begin = offset(last);
+				op.end = offset(format_begin);
+				op.has_index = pos_found;
+				if(pos_found)
+				{
+					Iter stop = skip_num(last, pos_end, op.dynamic);
+					op.index_begin = offset(last);
+					op.index_stop = offset(stop);
+					op.index_end = offset(pos_end);
+					if(!op.dynamic)
+					{
+						op.index = static_num(last, stop);
+					}
+				}
+				ops.push_back(std::move(op));
+				program->num_specs++;
+			}
+			++format_begin;
+			last = format_begin;
+		}else if(*format_begin == '{')
+		{
+			add_text(last, format_begin);
+
+			auto color_begin = format_begin;
+
+			++format_begin;
+			if(format_begin == format_end)
+			{
+				amx_FormalError(errors::invalid_format, "unexpected end");
+			}
+
+			format_program::op op{};
+			op.has_index = true;
+			op.index_begin = offset(format_begin);
+			Iter stop = skip_num(format_begin, format_end, op.dynamic);
+			op.index_stop = offset(stop);
+			if(!op.dynamic)
+			{
+				op.index = static_num(format_begin, stop);
+			}
+			format_begin = stop;
+
+			if(format_begin == format_end)
+			{
+				amx_FormalError(errors::invalid_format, "expected ':'");
+			}
+			if(*format_begin != ':')
+			{
+				auto color_end = std::find(format_begin, format_end, '}');
+				if(color_end != format_end && color_end - color_begin == 7)
+				{
+					if(std::all_of(std::next(color_begin), color_end, [](cell c) {return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F'); }))
+					{
+						++color_end;
+						add_text(color_begin, color_end);
+						format_begin = last = color_end;
+						continue;
+					}
+				}
+				op.type = op_type::expression;
+				op.expr = expression_parser<Iter>(parser_options::all).parse_simple(amx, std::next(color_begin), color_end);
+				if(color_end == format_end)
+				{
+					amx_FormalError(errors::invalid_format, "unexpected end");
+				}
+				ops.push_back(std::move(op));
+
+				++color_end;
+				format_begin = last = color_end;
+				continue;
+			}
+
+			last = format_begin;
+			auto lastspec = format_begin;
+			++format_begin;
+
+			while(format_begin != format_end && *format_begin != '}')
+			{
+				lastspec = format_begin;
+				++format_begin;
+			}
+			if(format_begin == format_end)
+			{
+				amx_FormalError(errors::invalid_format, "unexpected end");
+			}
+			if(last == lastspec)
+			{
+				amx_FormalError(errors::invalid_format, "missing specifier");
+			}
+			++last;
+
+			op.type = op_type::brace;
+			op.spec = *lastspec;
+			op.begin = offset(last);
+			op.end = offset(lastspec);
+			ops.push_back(std::move(op));
+			program->num_specs++;
+
+			++format_begin;
+			last = format_begin;
+		}else if(*format_begin == '}')
+		{
+			amx_FormalError(errors::invalid_format, "unexpected '}'");
+		}else{
+			++format_begin;
+		}
+	}
+	add_text(last, format_end);
+	return program;
+}
+
+void strings::format(AMX *amx, strings::cell_string &buf, const format_program &program, cell argc, cell *args)
 {
-	select_iterator<format_base>(format, amx, buf, argc, args);
+	typedef format_program::op_type op_type;
+
+	format_base<cell_string::const_iterator> base;
+	base.amx = amx;
+	base.argc = argc;
+	base.args = args;
+
+	buf.reserve(buf.size() + program.literals.size() + 8 * program.num_specs);
+
+	auto text = program.text.cbegin();
+	for(const auto &op : program.ops)
+	{
+		switch(op.type)
+		{
+			case op_type::text:
+			{
+				buf.append(program.literals, op.begin, op.end - op.begin);
+			}
+			break;
+			case op_type::percent:
+			{
+				auto params = text + op.begin;
+				cell argi = -1;
+				if(op.has_index)
+				{
+					if(op.dynamic)
+					{
+						auto index_begin = text + op.index_begin;
+						argi = base.parse_num(index_begin, text + op.index_end);
+					}else{
+						argi = op.index;
+					}
+					if(argi >= 0 && op.index_stop == op.index_end)
+					{
+						params = text + op.index_end + 1;
+					}else{
+						params = text + op.index_stop;
+						argi = -1;
+					}
+				}
+				if(argi < 0)
+				{
+					argi = ++base.argn;
+				}
+				if(argi < argc)
+				{
+					base.add_format(buf, params, text + op.end, op.spec, base.get_arg(argi));
+				}else if(argi > base.maxargn)
+				{
+					base.maxargn = argi;
+				}
+			}
+			break;
+			case op_type::brace:
+			case op_type::expression:
+			{
+				cell argi = op.index;
+				if(op.dynamic)
+				{
+					auto index_begin = text + op.index_begin;
+					argi = base.parse_num(index_begin, program.text.cend());
+				}
+				if(op.type == op_type::expression)
+				{
+					auto lock = format_env.size() > 0 ? format_env.top().lock() : std::shared_ptr<map_t>();
+					buf.append(op.expr->execute({}, expression::exec_info(amx, lock.get(), true)).to_string());
+				}else if(argi < 0)
+				{
+					amx_FormalError(errors::invalid_format, "negative argument index");
+				}else if(argi < argc)
+				{
+					base.add_format(buf, text + op.begin, text + op.end, op.spec, base.get_arg(argi));
+				}else if(argi > base.maxargn)
+				{
+					base.maxargn = argi;
+				}
+			}
+			break;
+		}
+	}
+
+	if(base.maxargn >= argc)
+	{
+		throw errors::end_of_arguments_error(args, base.maxargn + 1);
+	}
+}
+
+// Compiled formats are kept until they are deleted or the script is unloaded, and compiling the same string again returns the same one.
+struct format_cache : public amx::extra
+{
+	static constexpr amx::extra_slot slot = amx::extra_slot::format_cache;
+
+	std::unordered_map<cell_string, cell> ids;
+	// shared with the forks of the script, so that the ids stay valid there
+	std::vector<std::shared_ptr<const format_program>> programs;
+
+	// formats passed directly to str_format and similar, most recently used first
+	static constexpr size_t recent_capacity = 64;
+	typedef std::list<std::shared_ptr<const format_program>> recent_list;
+	recent_list recent;
+	std::unordered_map<cell_string, recent_list::iterator> recent_index;
+
+	format_cache(AMX *amx) : amx::extra(amx)
+	{
+
+	}
+
+	format_cache(AMX *amx, const format_cache &cache) : amx::extra(amx), ids(cache.ids), programs(cache.programs)
+	{
+
+	}
+
+	virtual std::unique_ptr<extra> clone() override
+	{
+		return std::unique_ptr<extra>(new format_cache(_amx, *this));
+	}
+
+	std::shared_ptr<const format_program> find(const cell_string &format)
+	{
+		auto it = ids.find(format);
+		if(it != ids.end())
+		{
+			return programs[it->second - 1];
+		}
+		auto rit = recent_index.find(format);
+		if(rit != recent_index.end())
+		{
+			recent.splice(recent.begin(), recent, rit->second);
+			return *rit->second;
+		}
+		return nullptr;
+	}
+
+	void add_recent(std::shared_ptr<const format_program> program)
+	{
+		recent.push_front(program);
+		recent_index[program->text] = recent.begin();
+		while(recent.size() > recent_capacity)
+		{
+			recent_index.erase(recent.back()->text);
+			recent.pop_back();
+		}
+	}
+};
+
+cell strings::format_compile(AMX *amx, const cell_string &format)
+{
+	auto obj = amx::load_lock(amx);
+	auto &cache = obj->get_extra<format_cache>();
+	auto it = cache.ids.find(format);
+	if(it != cache.ids.end())
+	{
+		return it->second;
+	}
+	auto program = compile_format(amx, cell_string(format));
+	cache.programs.push_back(std::move(program));
+	cell id = static_cast<cell>(cache.programs.size());
+	cache.ids.emplace(format, id);
+	return id;
+}
+
+cell strings::format_compile(AMX *amx, const cell *format)
+{
+	return format_compile(amx, convert(format));
+}
+
+std::shared_ptr<const format_program> strings::format_find(AMX *amx, cell id)
+{
+	auto obj = amx::load_lock(amx);
+	auto &cache = obj->get_extra<format_cache>();
+	if(id <= 0 || static_cast<ucell>(id) > cache.programs.size())
+	{
+		return nullptr;
+	}
+	return cache.programs[id - 1];
+}
+
+bool strings::format_delete(AMX *amx, cell id)
+{
+	auto obj = amx::load_lock(amx);
+	auto &cache = obj->get_extra<format_cache>();
+	if(id <= 0 || static_cast<ucell>(id) > cache.programs.size() || !cache.programs[id - 1])
+	{
+		return false;
+	}
+	// the slot is kept empty so that the id is not given to another format
+	cache.ids.erase(cache.programs[id - 1]->text);
+	cache.programs[id - 1] = nullptr;
+	return true;
 }
 
 void strings::format(AMX *amx, strings::cell_string &buf, const cell_string &format, cell argc, cell *args)
 {
-	format_base<cell_string::const_iterator>()(format.begin(), format.end(), amx, buf, argc, args);
+	std::shared_ptr<const format_program> program;
+	{
+		auto obj = amx::load_lock(amx);
+		auto &cache = obj->get_extra<format_cache>();
+		program = cache.find(format);
+		if(!program)
+		{
+			program = compile_format(amx, cell_string(format));
+			cache.add_recent(program);
+		}
+	}
+	// the program is held here, since evaluating the format may evict it from the cache
+	strings::format(amx, buf, *program, argc, args);
+}
+
+void strings::format(AMX *amx, strings::cell_string &buf, const cell *format, cell argc, cell *args)
+{
+	strings::format(amx, buf, convert(format), argc, args);
 }
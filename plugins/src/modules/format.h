@@ -12,6 +12,15 @@ namespace strings
 
 	void format(AMX *amx, strings::cell_string &str, const cell_string &format, cell argc, cell *args);
 	void format(AMX *amx, strings::cell_string &str, const cell *format, cell argc, cell *args);
+
+	// Format string split into text and specifiers when compiled, so that it is not parsed on every use.
+	class format_program;
+
+	cell format_compile(AMX *amx, const cell *format);
+	cell format_compile(AMX *amx, const cell_string &format);
+	std::shared_ptr<const format_program> format_find(AMX *amx, cell id);
+	bool format_delete(AMX *amx, cell id);
+	void format(AMX *amx, strings::cell_string &str, const format_program &format, cell argc, cell *args);
 }
 
 #endif
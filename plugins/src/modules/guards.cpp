@@ -6,6 +6,8 @@
 
 struct guards_extra : public amx::extra
 {
+	static constexpr amx::extra_slot slot = amx::extra_slot::guards;
+
 	aux::id_set_pool<handle_t> pool;
 
 	guards_extra(AMX *amx) : amx::extra(amx)
@@ -1,9 +1,13 @@
 #include "regex.h"
+#include "regex_automaton.h"
 #include "errors.h"
 #include "modules/expressions.h"
 #include "objects/stored_param.h"
 
 #include <regex>
+#include <list>
+#include <functional>
+#include <mutex>
 
 using namespace strings;
 
@@ -228,6 +232,100 @@ static std::regex_iterator<BidirIt, CharT, Traits> make_regex_iterator(BidirIt a
 	return {a, b, re, m};
 }
 
+template <class Iter>
+using match_list = std::vector<std::sub_match<Iter>>;
+
+// Pattern matched by regex_automaton if possible, otherwise by std::basic_regex.
+class cell_regex
+{
+	std::unique_ptr<regex_automaton> automaton;
+	std::unique_ptr<std::basic_regex<cell, regex_traits>> regex;
+	size_t pattern_size;
+
+public:
+	template <class Iter>
+	cell_regex(Iter pattern_begin, Iter pattern_end, std::regex_constants::syntax_option_type syntax_options) : pattern_size(std::distance(pattern_begin, pattern_end))
+	{
+		if((syntax_options & std::regex_constants::ECMAScript) && !(syntax_options & std::regex_constants::collate))
+		{
+			cell_string pattern(pattern_begin, pattern_end);
+			automaton = regex_automaton::compile(pattern.data(), pattern.data() + pattern.size(), !!(syntax_options & std::regex_constants::icase), !!(syntax_options & std::regex_constants::nosubs));
+		}
+		if(!automaton)
+		{
+			regex = std::unique_ptr<std::basic_regex<cell, regex_traits>>(new std::basic_regex<cell, regex_traits>(pattern_begin, pattern_end, syntax_options));
+		}
+	}
+
+	cell_regex(const cell_string &pattern, std::regex_constants::syntax_option_type syntax_options) : cell_regex(pattern.begin(), pattern.end(), syntax_options)
+	{
+
+	}
+
+	size_t mark_count() const
+	{
+		if(automaton)
+		{
+			return automaton->mark_count();
+		}
+		return regex->mark_count();
+	}
+
+	// approximate number of bytes used by the compiled pattern
+	size_t memory_size() const
+	{
+		if(automaton)
+		{
+			return sizeof(cell_regex) + automaton->memory_size();
+		}
+		// the states of std::basic_regex are not accessible, so their size is estimated from the pattern
+		return sizeof(cell_regex) + sizeof(std::basic_regex<cell, regex_traits>) + pattern_size * 128;
+	}
+
+	template <class StringIter>
+	bool search(StringIter begin, StringIter end, match_list<StringIter> &result, std::regex_constants::match_flag_type match_options) const
+	{
+		if(!automaton)
+		{
+			std::match_results<StringIter> match;
+			if(!std::regex_search(begin, end, match, *regex, match_options))
+			{
+				return false;
+			}
+			result.assign(match.begin(), match.end());
+			return true;
+		}
+
+		unsigned flags = 0;
+		if(match_options & std::regex_constants::match_not_bol) flags |= regex_automaton::match_not_bol;
+		if(match_options & std::regex_constants::match_not_eol) flags |= regex_automaton::match_not_eol;
+		if(match_options & std::regex_constants::match_prev_avail) flags |= regex_automaton::match_prev_avail;
+		if(match_options & std::regex_constants::match_not_null) flags |= regex_automaton::match_not_null;
+		if(match_options & std::regex_constants::match_continuous) flags |= regex_automaton::match_continuous;
+
+		const cell *data = begin != end ? &*begin : nullptr;
+		std::vector<std::ptrdiff_t> groups;
+		if(!automaton->search(data, data + (end - begin), flags, groups))
+		{
+			return false;
+		}
+		result.resize(groups.size() / 2);
+		for(size_t i = 0; i < result.size(); i++)
+		{
+			auto &group = result[i];
+			group.matched = groups[i * 2] >= 0;
+			if(group.matched)
+			{
+				group.first = begin + groups[i * 2];
+				group.second = begin + groups[i * 2 + 1];
+			}else{
+				group.first = group.second = end;
+			}
+		}
+		return true;
+	}
+};
+
 constexpr const cell cache_flag = 4194304;
 constexpr const cell cache_addr_flag = 4194304 | 8388608;
 
@@ -336,31 +434,232 @@ static const char *get_error(std::regex_constants::error_type code)
 	return "unknown";
 }
 
-static std::unordered_map<std::pair<cell_string, cell>, std::basic_regex<cell, regex_traits>> regex_cache;
+// Patterns compiled with cache_flag, evicted in least recently used order when their total size exceeds the capacity.
+// Patterns with cache_addr_flag are keyed by their address, but their contents are still compared on every lookup.
+class regex_cache_type
+{
+	struct entry
+	{
+		cell_string pattern;
+		cell options;
+		const void *addr_begin;
+		const void *addr_end;
+		std::shared_ptr<const cell_regex> regex;
+		size_t size;
+	};
+
+	typedef std::list<entry>::iterator entry_iterator;
+
+	// the cache is shared by all threads; regexes are compiled outside of the lock
+	std::mutex mutex;
+	std::list<entry> entries;
+	std::unordered_map<std::pair<cell_string, cell>, entry_iterator> by_pattern;
+	std::unordered_map<std::tuple<const void*, const void*, cell>, entry_iterator> by_addr;
+	size_t used = 0;
+	size_t capacity = 4 * 1024 * 1024;
+	size_t hits = 0;
+	size_t misses = 0;
+
+	static size_t entry_size(const entry &e)
+	{
+		size_t size = sizeof(entry) + e.pattern.capacity() * sizeof(cell) + e.regex->memory_size();
+		if(e.addr_begin == nullptr)
+		{
+			// the key in by_pattern holds another copy of the pattern
+			size += sizeof(std::pair<cell_string, cell>) + e.pattern.size() * sizeof(cell);
+		}
+		return size + 4 * sizeof(void*);
+	}
+
+	std::shared_ptr<const cell_regex> touch(entry_iterator it)
+	{
+		hits++;
+		entries.splice(entries.begin(), entries, it);
+		// the automaton may have grown its DFA; its size is tracked as it grows, so this is cheap
+		used -= it->size;
+		it->size = entry_size(*it);
+		used += it->size;
+		auto regex = it->regex;
+		trim();
+		return regex;
+	}
 
-static const std::basic_regex<cell, regex_traits> &get_cached(const cell_string &pattern, cell options, std::regex_constants::syntax_option_type syntax_options)
+	std::shared_ptr<const cell_regex> insert(entry &&e)
+	{
+		misses++;
+		entries.push_front(std::move(e));
+		auto it = entries.begin();
+		bool inserted;
+		if(it->addr_begin == nullptr)
+		{
+			inserted = by_pattern.emplace(std::make_pair(it->pattern, it->options), it).second;
+		}else{
+			inserted = by_addr.emplace(std::make_tuple(it->addr_begin, it->addr_end, it->options), it).second;
+		}
+		if(!inserted)
+		{
+			// another thread has compiled the same pattern in the meantime
+			auto regex = it->regex;
+			entries.erase(it);
+			return regex;
+		}
+		it->size = entry_size(*it);
+		used += it->size;
+		auto regex = it->regex;
+		trim();
+		return regex;
+	}
+
+	void erase(entry_iterator it)
+	{
+		if(it->addr_begin == nullptr)
+		{
+			by_pattern.erase(std::make_pair(it->pattern, it->options));
+		}else{
+			by_addr.erase(std::make_tuple(it->addr_begin, it->addr_end, it->options));
+		}
+		used -= it->size;
+		entries.erase(it);
+	}
+
+	void trim()
+	{
+		while(used > capacity && !entries.empty())
+		{
+			erase(std::prev(entries.end()));
+		}
+	}
+
+public:
+	std::shared_ptr<const cell_regex> get(const cell_string &pattern, cell options, std::regex_constants::syntax_option_type syntax_options)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			auto it = by_pattern.find(std::make_pair(pattern, options));
+			if(it != by_pattern.end())
+			{
+				return touch(it->second);
+			}
+		}
+		auto regex = std::make_shared<const cell_regex>(pattern, syntax_options);
+		std::lock_guard<std::mutex> lock(mutex);
+		return insert(entry{pattern, options, nullptr, nullptr, std::move(regex), 0});
+	}
+
+	template <class Iter>
+	std::shared_ptr<const cell_regex> get(Iter pattern_begin, Iter pattern_end, cell options, std::regex_constants::syntax_option_type syntax_options)
+	{
+		return get(cell_string(pattern_begin, pattern_end), options, syntax_options);
+	}
+
+	template <class Iter>
+	std::shared_ptr<const cell_regex> get_addr(Iter pattern_begin, Iter pattern_end, cell options, std::regex_constants::syntax_option_type syntax_options)
+	{
+		const void *addr_begin = &*pattern_begin;
+		const void *addr_end = &*pattern_end;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			auto it = by_addr.find(std::make_tuple(addr_begin, addr_end, options));
+			if(it != by_addr.end())
+			{
+				const auto &pattern = it->second->pattern;
+				if(static_cast<size_t>(std::distance(pattern_begin, pattern_end)) == pattern.size() && std::equal(pattern_begin, pattern_end, pattern.begin()))
+				{
+					return touch(it->second);
+				}
+				erase(it->second);
+			}
+		}
+		auto regex = std::make_shared<const cell_regex>(pattern_begin, pattern_end, syntax_options);
+		std::lock_guard<std::mutex> lock(mutex);
+		return insert(entry{cell_string(pattern_begin, pattern_end), options, addr_begin, addr_end, std::move(regex), 0});
+	}
+
+	// removes the patterns keyed by an address in the range
+	void release(const void *begin, const void *end)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		std::less<const void*> less;
+		for(auto it = entries.begin(); it != entries.end();)
+		{
+			auto next = std::next(it);
+			if(it->addr_begin != nullptr && !less(it->addr_begin, begin) && less(it->addr_begin, end))
+			{
+				erase(it);
+			}
+			it = next;
+		}
+	}
+
+	void set_capacity(size_t size)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		capacity = size;
+		trim();
+	}
+
+	size_t get_capacity()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return capacity;
+	}
+
+	size_t stats(size_t &hits, size_t &misses, size_t &count)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		hits = this->hits;
+		misses = this->misses;
+		count = entries.size();
+		return used;
+	}
+};
+
+static regex_cache_type regex_cache;
+
+static std::shared_ptr<const cell_regex> get_cached(const cell_string &pattern, cell options, std::regex_constants::syntax_option_type syntax_options)
 {
 	options &= 255;
-	return regex_cache.emplace(std::piecewise_construct, std::forward_as_tuple(pattern, options), std::forward_as_tuple(pattern, syntax_options)).first->second;
+	return regex_cache.get(pattern, options, syntax_options);
 }
 
 template <class Iter>
-static const std::basic_regex<cell, regex_traits> &get_cached(Iter pattern_begin, Iter pattern_end, const cell_string *pattern, cell options, std::regex_constants::syntax_option_type syntax_options)
+static std::shared_ptr<const cell_regex> get_cached(Iter pattern_begin, Iter pattern_end, const cell_string *pattern, cell options, std::regex_constants::syntax_option_type syntax_options)
 {
 	if(pattern != nullptr)
 	{
 		return get_cached(*pattern, options, syntax_options);
 	}
 	options &= 255;
-	return regex_cache.emplace(std::piecewise_construct, std::forward_as_tuple(cell_string(pattern_begin, pattern_end), options), std::forward_as_tuple(pattern_begin, pattern_end, syntax_options)).first->second;
+	return regex_cache.get(pattern_begin, pattern_end, options, syntax_options);
 }
 
 template <class Iter>
-static const std::basic_regex<cell, regex_traits> &get_cached_addr(Iter pattern_begin, Iter pattern_end, cell options, std::regex_constants::syntax_option_type syntax_options)
+static std::shared_ptr<const cell_regex> get_cached_addr(Iter pattern_begin, Iter pattern_end, cell options, std::regex_constants::syntax_option_type syntax_options)
 {
-	static std::unordered_map<std::tuple<const void*, const void*, cell>, std::basic_regex<cell, regex_traits>> regex_cache;
 	options &= 255;
-	return regex_cache.emplace(std::piecewise_construct, std::forward_as_tuple(&*pattern_begin, &*pattern_end, options), std::forward_as_tuple(pattern_begin, pattern_end, syntax_options)).first->second;
+	return regex_cache.get_addr(pattern_begin, pattern_end, options, syntax_options);
+}
+
+size_t strings::regex_cache_stats(size_t &hits, size_t &misses, size_t &count)
+{
+	return regex_cache.stats(hits, misses, count);
+}
+
+size_t strings::get_regex_cache_capacity()
+{
+	return regex_cache.get_capacity();
+}
+
+void strings::set_regex_cache_capacity(size_t capacity)
+{
+	regex_cache.set_capacity(capacity);
+}
+
+void strings::regex_cache_release(AMX *amx)
+{
+	auto hdr = reinterpret_cast<AMX_HEADER*>(amx->base);
+	unsigned char *data = amx->data != nullptr ? amx->data : amx->base + hdr->dat;
+	regex_cache.release(data, data + amx->stp);
 }
 
 template <class Iter>
@@ -380,17 +679,18 @@ struct regex_search_base
 			match_options |= std::regex_constants::match_prev_avail;
 		}
 		auto begin = str.cbegin() + *pos;
-		std::match_results<cell_string::const_iterator> match;
+		match_list<cell_string::const_iterator> match;
 		if(options & cache_flag)
 		{
-			const std::basic_regex<cell, regex_traits> &regex = options & cache_addr_flag ? get_cached_addr(pattern_begin, pattern_end, options, syntax_options) : get_cached(pattern_begin, pattern_end, pattern, options, syntax_options);
-			if(!std::regex_search(begin, str.cend(), match, regex, match_options))
+			auto cached = options & cache_addr_flag ? get_cached_addr(pattern_begin, pattern_end, options, syntax_options) : get_cached(pattern_begin, pattern_end, pattern, options, syntax_options);
+			const cell_regex &regex = *cached;
+			if(!regex.search(begin, str.cend(), match, match_options))
 			{
 				return false;
 			}
 		}else{
-			std::basic_regex<cell, regex_traits> regex(pattern_begin, pattern_end, syntax_options);
-			if(!std::regex_search(begin, str.cend(), match, regex, match_options))
+			cell_regex regex(pattern_begin, pattern_end, syntax_options);
+			if(!regex.search(begin, str.cend(), match, match_options))
 			{
 				return false;
 			}
@@ -439,17 +739,18 @@ struct regex_extract_base
 			match_options |= std::regex_constants::match_prev_avail;
 		}
 		auto begin = str.cbegin() + *pos;
-		std::match_results<cell_string::const_iterator> match;
+		match_list<cell_string::const_iterator> match;
 		if(options & cache_flag)
 		{
-			const std::basic_regex<cell, regex_traits> &regex = options & cache_addr_flag ? get_cached_addr(pattern_begin, pattern_end, options, syntax_options) : get_cached(pattern_begin, pattern_end, pattern, options, syntax_options);
-			if(!std::regex_search(begin, str.cend(), match, regex, match_options))
+			auto cached = options & cache_addr_flag ? get_cached_addr(pattern_begin, pattern_end, options, syntax_options) : get_cached(pattern_begin, pattern_end, pattern, options, syntax_options);
+			const cell_regex &regex = *cached;
+			if(!regex.search(begin, str.cend(), match, match_options))
 			{
 				return 0;
 			}
 		}else{
-			std::basic_regex<cell, regex_traits> regex(pattern_begin, pattern_end, syntax_options);
-			if(!std::regex_search(begin, str.cend(), match, regex, match_options))
+			cell_regex regex(pattern_begin, pattern_end, syntax_options);
+			if(!regex.search(begin, str.cend(), match, match_options))
 			{
 				return 0;
 			}
@@ -545,14 +846,14 @@ struct replace_sub_match_base
 };
 
 template <class StringIter, class ReplacementIter>
-void replace(cell_string &target, StringIter &begin, StringIter end, const std::basic_regex<cell, regex_traits> &regex, ReplacementIter replacement_begin, ReplacementIter replacement_end, std::regex_constants::match_flag_type match_options)
+void replace(cell_string &target, StringIter &begin, StringIter end, const cell_regex &regex, ReplacementIter replacement_begin, ReplacementIter replacement_end, std::regex_constants::match_flag_type match_options)
 {
-	std::match_results<StringIter> result;
-	while(std::regex_search(begin, end, result, regex, match_options))
+	match_list<StringIter> result;
+	while(regex.search(begin, end, result, match_options))
 	{
 		const auto &group = result[0];
 		target.append(begin, group.first);
-		typename replace_sub_match_base<typename std::match_results<StringIter>::const_iterator>::template inner<ReplacementIter>()(replacement_begin, replacement_end, target, std::next(result.cbegin()), result.cend());
+		typename replace_sub_match_base<typename match_list<StringIter>::const_iterator>::template inner<ReplacementIter>()(replacement_begin, replacement_end, target, std::next(result.cbegin()), result.cend());
 		if(group.second != begin)
 		{
 			match_options |= std::regex_constants::match_prev_avail;
@@ -585,10 +886,11 @@ struct regex_replace_base
 			target.append(str.cbegin(), begin);
 			if(options & cache_flag)
 			{
-				const std::basic_regex<cell, regex_traits> &regex = options & cache_addr_flag ? get_cached_addr(pattern_begin, pattern_end, options, syntax_options) : get_cached(pattern_begin, pattern_end, pattern, options, syntax_options);
+				auto cached = options & cache_addr_flag ? get_cached_addr(pattern_begin, pattern_end, options, syntax_options) : get_cached(pattern_begin, pattern_end, pattern, options, syntax_options);
+				const cell_regex &regex = *cached;
 				replace(target, begin, str.cend(), regex, replacement_begin, replacement_end, match_options);
 			}else{
-				std::basic_regex<cell, regex_traits> regex(pattern_begin, pattern_end, syntax_options);
+				cell_regex regex(pattern_begin, pattern_end, syntax_options);
 				replace(target, begin, str.cend(), regex, replacement_begin, replacement_end, match_options);
 			}
 			*pos = begin - str.cbegin();
@@ -622,21 +924,22 @@ void strings::regex_replace(cell_string &target, const cell_string &str, const c
 }
 
 template <class StringIter>
-void replace(cell_string &target, StringIter &begin, StringIter end, const std::basic_regex<cell, regex_traits> &regex, const list_t &replacement, std::regex_constants::match_flag_type match_options)
+void replace(cell_string &target, StringIter &begin, StringIter end, const cell_regex &regex, const list_t &replacement, std::regex_constants::match_flag_type match_options)
 {
-	std::match_results<StringIter> result;
-	while(std::regex_search(begin, end, result, regex, match_options))
+	match_list<StringIter> result;
+	while(regex.search(begin, end, result, match_options))
 	{
 		const auto &group = result[0];
 		target.append(begin, group.first);
 		size_t index = 0;
+		dyn_object buffer;
 		for(auto it = std::next(result.cbegin()); it != result.cend();)
 		{
 			index++;
 			const auto &capture = *it;
 			if(capture.matched && index <= replacement.size())
 			{
-				const dyn_object &repl = replacement[index - 1];
+				const dyn_object &repl = replacement.get(index - 1, buffer);
 
 				auto begin = it;
 				++it;
@@ -649,16 +952,16 @@ void replace(cell_string &target, StringIter &begin, StringIter end, const std::
 					cell_string *repl_str;
 					if(strings::pool.get_by_id(value, repl_str))
 					{
-						typename replace_sub_match_base<typename std::match_results<StringIter>::const_iterator>::template inner<cell_string::const_iterator>()(repl_str->cbegin(), repl_str->cend(), target, begin, end);
+						typename replace_sub_match_base<typename match_list<StringIter>::const_iterator>::template inner<cell_string::const_iterator>()(repl_str->cbegin(), repl_str->cend(), target, begin, end);
 						continue;
 					}
 				}else if(repl.get_tag()->inherits_from(tags::tag_char) && repl.is_array())
 				{
-					select_iterator<replace_sub_match_base<typename std::match_results<StringIter>::const_iterator>::template inner>(repl.begin(), target, begin, end);
+					select_iterator<replace_sub_match_base<typename match_list<StringIter>::const_iterator>::template inner>(repl.begin(), target, begin, end);
 					continue;
 				}
 				cell_string str = repl.to_string();
-				typename replace_sub_match_base<typename std::match_results<StringIter>::const_iterator>::template inner<cell_string::const_iterator>()(str.cbegin(), str.cend(), target, begin, end);
+				typename replace_sub_match_base<typename match_list<StringIter>::const_iterator>::template inner<cell_string::const_iterator>()(str.cbegin(), str.cend(), target, begin, end);
 			}else{
 				++it;
 			}
@@ -692,10 +995,11 @@ struct regex_replace_list_base
 		target.append(str.cbegin(), begin);
 		if(options & cache_flag)
 		{
-			const std::basic_regex<cell, regex_traits> &regex = options & cache_addr_flag ? get_cached_addr(pattern_begin, pattern_end, options, syntax_options) : get_cached(pattern_begin, pattern_end, pattern, options, syntax_options);
+			auto cached = options & cache_addr_flag ? get_cached_addr(pattern_begin, pattern_end, options, syntax_options) : get_cached(pattern_begin, pattern_end, pattern, options, syntax_options);
+			const cell_regex &regex = *cached;
 			replace(target, begin, str.cend(), regex, replacement, match_options);
 		}else{
-			std::basic_regex<cell, regex_traits> regex(pattern_begin, pattern_end, syntax_options);
+			cell_regex regex(pattern_begin, pattern_end, syntax_options);
 			replace(target, begin, str.cend(), regex, replacement, match_options);
 		}
 		*pos = begin - str.cbegin();
@@ -723,7 +1027,7 @@ void strings::regex_replace(cell_string &target, const cell_string &str, const c
 }
 
 template <class StringIter>
-void replace(cell_string &target, StringIter &begin, StringIter end, const std::basic_regex<cell, regex_traits> &regex, AMX *amx, int replacement_index, std::regex_constants::match_flag_type match_options, const char *format, cell *params, size_t numargs)
+void replace(cell_string &target, StringIter &begin, StringIter end, const cell_regex &regex, AMX *amx, int replacement_index, std::regex_constants::match_flag_type match_options, const char *format, cell *params, size_t numargs)
 {
 	std::vector<stored_param> arg_values;
 	if(format != nullptr)
@@ -736,8 +1040,8 @@ void replace(cell_string &target, StringIter &begin, StringIter end, const std::
 		}
 	}
 
-	std::match_results<StringIter> result;
-	while(std::regex_search(begin, end, result, regex, match_options))
+	match_list<StringIter> result;
+	while(regex.search(begin, end, result, match_options))
 	{
 		const auto &group = result[0];
 		target.append(begin, group.first);
@@ -814,10 +1118,11 @@ struct regex_replace_func_base
 		target.append(str.cbegin(), begin);
 		if(options & cache_flag)
 		{
-			const std::basic_regex<cell, regex_traits> &regex = options & cache_addr_flag ? get_cached_addr(pattern_begin, pattern_end, options, syntax_options) : get_cached(pattern_begin, pattern_end, pattern, options, syntax_options);
+			auto cached = options & cache_addr_flag ? get_cached_addr(pattern_begin, pattern_end, options, syntax_options) : get_cached(pattern_begin, pattern_end, pattern, options, syntax_options);
+			const cell_regex &regex = *cached;
 			replace(target, begin, str.cend(), regex, amx, replacement_index, match_options, format, params, numargs);
 		}else{
-			std::basic_regex<cell, regex_traits> regex(pattern_begin, pattern_end, syntax_options);
+			cell_regex regex(pattern_begin, pattern_end, syntax_options);
 			replace(target, begin, str.cend(), regex, amx, replacement_index, match_options, format, params, numargs);
 		}
 		*pos = begin - str.cbegin();
@@ -845,7 +1150,7 @@ void strings::regex_replace(cell_string &target, const cell_string &str, const c
 }
 
 template <class StringIter>
-void replace(cell_string &target, StringIter &begin, StringIter end, const std::basic_regex<cell, regex_traits> &regex, AMX *amx, const expression &expr, std::regex_constants::match_flag_type match_options)
+void replace(cell_string &target, StringIter &begin, StringIter end, const cell_regex &regex, AMX *amx, const expression &expr, std::regex_constants::match_flag_type match_options)
 {
 	expression::exec_info info(amx);
 
@@ -857,8 +1162,8 @@ void replace(cell_string &target, StringIter &begin, StringIter end, const std::
 		ref_args.push_back(std::cref(arg));
 	}
 
-	std::match_results<StringIter> result;
-	while(std::regex_search(begin, end, result, regex, match_options))
+	match_list<StringIter> result;
+	while(regex.search(begin, end, result, match_options))
 	{
 		auto group = result[0];
 		target.append(begin, group.first);
@@ -911,10 +1216,11 @@ struct regex_replace_expr_base
 		target.append(str.cbegin(), begin);
 		if(options & cache_flag)
 		{
-			const std::basic_regex<cell, regex_traits> &regex = options & cache_addr_flag ? get_cached_addr(pattern_begin, pattern_end, options, syntax_options) : get_cached(pattern_begin, pattern_end, pattern, options, syntax_options);
+			auto cached = options & cache_addr_flag ? get_cached_addr(pattern_begin, pattern_end, options, syntax_options) : get_cached(pattern_begin, pattern_end, pattern, options, syntax_options);
+			const cell_regex &regex = *cached;
 			replace(target, begin, str.cend(), regex, amx, expr, match_options);
 		}else{
-			std::basic_regex<cell, regex_traits> regex(pattern_begin, pattern_end, syntax_options);
+			cell_regex regex(pattern_begin, pattern_end, syntax_options);
 			replace(target, begin, str.cend(), regex, amx, expr, match_options);
 		}
 		*pos = begin - str.cbegin();
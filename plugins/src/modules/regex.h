@@ -18,6 +18,11 @@ namespace strings
 	void regex_replace(cell_string &target, const cell_string &str, const cell_string &pattern, AMX *amx, int replacement_index, cell *pos, cell options, const char *format, cell *params, size_t numargs);
 	void regex_replace(cell_string &target, const cell_string &str, const cell *pattern, AMX *amx, const expression &expr, cell *pos, cell options);
 	void regex_replace(cell_string &target, const cell_string &str, const cell_string &pattern, AMX *amx, const expression &expr, cell *pos, cell options);
+
+	size_t regex_cache_stats(size_t &hits, size_t &misses, size_t &count);
+	size_t get_regex_cache_capacity();
+	void set_regex_cache_capacity(size_t capacity);
+	void regex_cache_release(AMX *amx);
 }
 
 #endif
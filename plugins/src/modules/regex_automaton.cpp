@@ -0,0 +1,911 @@
+#include "regex_automaton.h"
+#include "modules/strings.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace strings;
+
+namespace
+{
+	struct regex_node
+	{
+		enum kind_type
+		{
+			empty, chr, set, any, bol, eol, group, concat, alt, repeat
+		};
+
+		kind_type kind;
+		cell value = 0;
+		size_t min = 0;
+		size_t max = 0;
+		bool greedy = true;
+		std::vector<std::unique_ptr<regex_node>> children;
+
+		static constexpr size_t unbounded = static_cast<size_t>(-1);
+
+		regex_node(kind_type kind) : kind(kind)
+		{
+
+		}
+
+		bool nullable() const
+		{
+			switch(kind)
+			{
+				case empty:
+				case bol:
+				case eol:
+					return true;
+				case chr:
+				case set:
+				case any:
+					return false;
+				case group:
+					return children[0]->nullable();
+				case concat:
+					for(const auto &child : children)
+					{
+						if(!child->nullable()) return false;
+					}
+					return true;
+				case alt:
+					for(const auto &child : children)
+					{
+						if(child->nullable()) return true;
+					}
+					return false;
+				case repeat:
+					return min == 0 || children[0]->nullable();
+			}
+			return false;
+		}
+
+		bool has_groups() const
+		{
+			if(kind == group && value > 0)
+			{
+				return true;
+			}
+			for(const auto &child : children)
+			{
+				if(child->has_groups()) return true;
+			}
+			return false;
+		}
+	};
+
+	typedef std::unique_ptr<regex_node> node_ptr;
+
+	// Parses the subset of the ECMAScript grammar that is matched by the automaton in the same way as by std::regex.
+	// Any other construct makes the parser fail, so that the pattern is handled by std::regex.
+	class regex_parser
+	{
+		static constexpr size_t max_count = 1000;
+
+		const cell *pos;
+		const cell *end;
+		bool icase;
+		bool nosubs;
+		std::vector<regex_automaton::char_set> &sets;
+
+		static bool is_quantifier(cell c)
+		{
+			return c == '*' || c == '+' || c == '?' || c == '{';
+		}
+
+		static int hex_value(cell c)
+		{
+			if('0' <= c && c <= '9') return c - '0';
+			if('a' <= c && c <= 'f') return c - 'a' + 10;
+			if('A' <= c && c <= 'F') return c - 'A' + 10;
+			return -1;
+		}
+
+		bool parse_hex(size_t digits, cell &value)
+		{
+			value = 0;
+			for(size_t i = 0; i < digits; i++)
+			{
+				if(pos == end) return false;
+				int digit = hex_value(*pos++);
+				if(digit < 0) return false;
+				value = value * 16 + digit;
+			}
+			return true;
+		}
+
+		// parses an escape sequence denoting a single character, after the backslash
+		bool parse_escape(bool in_class, cell &value)
+		{
+			if(pos == end) return false;
+			cell c = *pos++;
+			switch(c)
+			{
+				case 't':
+					value = '\t';
+					return true;
+				case 'n':
+					value = '\n';
+					return true;
+				case 'r':
+					value = '\r';
+					return true;
+				case 'v':
+					value = '\v';
+					return true;
+				case 'f':
+					value = '\f';
+					return true;
+				case '0':
+					value = 0;
+					return true;
+				case 'b':
+					value = '\b';
+					return in_class;
+				case 'x':
+					return parse_hex(2, value);
+				case 'u':
+					return parse_hex(4, value);
+				case 'B':
+				case 'c':
+				case 'd':
+				case 'D':
+				case 's':
+				case 'S':
+				case 'w':
+				case 'W':
+					return false;
+			}
+			if('1' <= c && c <= '9')
+			{
+				return false;
+			}
+			value = c;
+			return true;
+		}
+
+		bool parse_count(size_t &value)
+		{
+			if(pos == end || *pos < '0' || *pos > '9') return false;
+			value = 0;
+			while(pos != end && *pos >= '0' && *pos <= '9')
+			{
+				value = value * 10 + (*pos++ - '0');
+				if(value > max_count) return false;
+			}
+			return true;
+		}
+
+		static bool match_range(cell lo, cell hi, cell c)
+		{
+			return lo <= c && c <= hi;
+		}
+
+		node_ptr make_set(const std::vector<cell> &chars, const std::vector<std::pair<cell, cell>> &ranges, std::ctype_base::mask classes, bool negated)
+		{
+			regex_automaton::char_set set;
+			set.negated = negated;
+			for(cell c = 0; c < 256; c++)
+			{
+				bool found = false;
+				if(icase)
+				{
+					cell lower = to_lower(c), upper = to_upper(c);
+					for(cell ch : chars)
+					{
+						if(to_lower(ch) == lower)
+						{
+							found = true;
+							break;
+						}
+					}
+					for(const auto &range : ranges)
+					{
+						if(found) break;
+						found = match_range(range.first, range.second, lower) || match_range(range.first, range.second, upper);
+					}
+				}else{
+					found = std::find(chars.begin(), chars.end(), c) != chars.end();
+					for(const auto &range : ranges)
+					{
+						if(found) break;
+						found = match_range(range.first, range.second, c);
+					}
+				}
+				if(!found && classes != 0)
+				{
+					found = std::ctype<cell>::base_facet->is(classes, static_cast<unsigned char>(c));
+				}
+				set.low[c] = found != negated;
+			}
+			for(cell ch : chars)
+			{
+				if(static_cast<ucell>(ch) >= 256)
+				{
+					set.high.push_back(std::make_pair(ch, ch));
+				}
+			}
+			for(const auto &range : ranges)
+			{
+				if(static_cast<ucell>(range.second) >= 256)
+				{
+					set.high.push_back(range);
+				}
+			}
+			sets.push_back(std::move(set));
+			node_ptr node(new regex_node(regex_node::set));
+			node->value = static_cast<cell>(sets.size() - 1);
+			return node;
+		}
+
+		node_ptr make_char(cell c)
+		{
+			if(icase)
+			{
+				return make_set({c}, {}, 0, false);
+			}
+			node_ptr node(new regex_node(regex_node::chr));
+			node->value = c;
+			return node;
+		}
+
+		bool parse_class_name(std::ctype_base::mask &classes)
+		{
+			static const std::pair<const char*, std::ctype_base::mask> names[] = {
+				{"alnum", std::ctype_base::alnum},
+				{"alpha", std::ctype_base::alpha},
+				{"cntrl", std::ctype_base::cntrl},
+				{"digit", std::ctype_base::digit},
+				{"graph", std::ctype_base::graph},
+				{"lower", std::ctype_base::lower},
+				{"print", std::ctype_base::print},
+				{"punct", std::ctype_base::punct},
+				{"space", std::ctype_base::space},
+				{"upper", std::ctype_base::upper},
+				{"xdigit", std::ctype_base::xdigit}
+			};
+
+			const cell *name = pos;
+			while(pos != end && *pos != ':') pos++;
+			if(end - pos < 2 || pos[1] != ']') return false;
+			size_t length = pos - name;
+			pos += 2;
+			for(const auto &entry : names)
+			{
+				if(std::strlen(entry.first) == length && std::equal(name, name + length, entry.first))
+				{
+					auto mask = entry.second;
+					if(icase && (mask & (std::ctype_base::lower | std::ctype_base::upper)))
+					{
+						mask |= std::ctype_base::lower | std::ctype_base::upper;
+					}
+					classes |= mask;
+					return true;
+				}
+			}
+			return false;
+		}
+
+		node_ptr parse_class()
+		{
+			bool negated = false;
+			if(pos != end && *pos == '^')
+			{
+				negated = true;
+				pos++;
+			}
+			std::vector<cell> chars;
+			std::vector<std::pair<cell, cell>> ranges;
+			std::ctype_base::mask classes = 0;
+			while(true)
+			{
+				if(pos == end) return nullptr;
+				cell c = *pos++;
+				if(c == ']')
+				{
+					break;
+				}
+				if(c == '[' && pos != end && (*pos == ':' || *pos == '.' || *pos == '='))
+				{
+					if(*pos++ != ':' || !parse_class_name(classes)) return nullptr;
+					if(end - pos >= 2 && pos[0] == '-' && pos[1] != ']') return nullptr;
+					continue;
+				}
+				if(c == '\\' && !parse_escape(true, c))
+				{
+					return nullptr;
+				}
+				if(end - pos >= 2 && pos[0] == '-' && pos[1] != ']')
+				{
+					pos++;
+					cell hi = *pos++;
+					if(hi == '[') return nullptr;
+					if(hi == '\\' && !parse_escape(true, hi)) return nullptr;
+					if(hi < c) return nullptr;
+					ranges.push_back(std::make_pair(c, hi));
+					if(end - pos >= 2 && pos[0] == '-' && pos[1] != ']') return nullptr;
+				}else{
+					chars.push_back(c);
+				}
+			}
+			return make_set(chars, ranges, classes, negated);
+		}
+
+		node_ptr parse_atom()
+		{
+			cell c = *pos++;
+			switch(c)
+			{
+				case '(':
+				{
+					cell index = -1;
+					if(pos != end && *pos == '?')
+					{
+						if(end - pos < 2 || pos[1] != ':') return nullptr;
+						pos += 2;
+					}else if(!nosubs)
+					{
+						index = static_cast<cell>(++groups);
+					}
+					auto inner = parse_disjunction();
+					if(!inner || pos == end || *pos != ')') return nullptr;
+					pos++;
+					if(index == -1)
+					{
+						return inner;
+					}
+					node_ptr node(new regex_node(regex_node::group));
+					node->value = index;
+					node->children.push_back(std::move(inner));
+					return node;
+				}
+				case '.':
+					return node_ptr(new regex_node(regex_node::any));
+				case '[':
+					return parse_class();
+				case '\\':
+					if(!parse_escape(false, c)) return nullptr;
+					return make_char(c);
+				case ')':
+				case '*':
+				case '+':
+				case '?':
+				case '{':
+					return nullptr;
+			}
+			return make_char(c);
+		}
+
+		node_ptr parse_term()
+		{
+			cell c = *pos;
+			if(c == '^' || c == '$')
+			{
+				pos++;
+				if(pos != end && is_quantifier(*pos)) return nullptr;
+				return node_ptr(new regex_node(c == '^' ? regex_node::bol : regex_node::eol));
+			}
+			auto atom = parse_atom();
+			if(!atom || pos == end || !is_quantifier(*pos))
+			{
+				return atom;
+			}
+			size_t min, max;
+			switch(*pos++)
+			{
+				case '*':
+					min = 0, max = regex_node::unbounded;
+					break;
+				case '+':
+					min = 1, max = regex_node::unbounded;
+					break;
+				case '?':
+					min = 0, max = 1;
+					break;
+				default:
+					if(!parse_count(min)) return nullptr;
+					max = min;
+					if(pos != end && *pos == ',')
+					{
+						pos++;
+						max = regex_node::unbounded;
+						if(pos != end && *pos != '}' && !parse_count(max)) return nullptr;
+					}
+					if(pos == end || *pos++ != '}' || max < min) return nullptr;
+					break;
+			}
+			bool greedy = true;
+			if(pos != end && *pos == '?')
+			{
+				greedy = false;
+				pos++;
+			}
+			if(pos != end && is_quantifier(*pos)) return nullptr;
+			// std::regex allows an additional empty iteration of a loop, visible in the groups inside
+			if(max == regex_node::unbounded && atom->has_groups() && atom->nullable()) return nullptr;
+			node_ptr node(new regex_node(regex_node::repeat));
+			node->min = min;
+			node->max = max;
+			node->greedy = greedy;
+			node->children.push_back(std::move(atom));
+			return node;
+		}
+
+		node_ptr parse_alternative()
+		{
+			node_ptr node(new regex_node(regex_node::concat));
+			while(pos != end && *pos != '|' && *pos != ')')
+			{
+				auto term = parse_term();
+				if(!term) return nullptr;
+				node->children.push_back(std::move(term));
+			}
+			return node;
+		}
+
+	public:
+		size_t groups = 0;
+
+		regex_parser(const cell *begin, const cell *end, bool icase, bool nosubs, std::vector<regex_automaton::char_set> &sets) : pos(begin), end(end), icase(icase), nosubs(nosubs), sets(sets)
+		{
+
+		}
+
+		node_ptr parse_disjunction()
+		{
+			node_ptr node(new regex_node(regex_node::alt));
+			while(true)
+			{
+				auto alternative = parse_alternative();
+				if(!alternative) return nullptr;
+				node->children.push_back(std::move(alternative));
+				if(pos == end || *pos != '|') break;
+				pos++;
+			}
+			return node;
+		}
+
+		node_ptr parse()
+		{
+			auto node = parse_disjunction();
+			if(pos != end) return nullptr;
+			return node;
+		}
+	};
+
+	class regex_emitter
+	{
+		static constexpr size_t max_program = 20000;
+
+		std::vector<regex_automaton::instruction> &program;
+
+	public:
+		regex_emitter(std::vector<regex_automaton::instruction> &program) : program(program)
+		{
+
+		}
+
+		size_t emit(regex_automaton::opcode op, cell value = 0, size_t x = 0, size_t y = 0)
+		{
+			program.push_back({op, value, x, y});
+			return program.size() - 1;
+		}
+
+		void split(size_t index, size_t preferred, size_t other, bool greedy)
+		{
+			program[index].x = greedy ? preferred : other;
+			program[index].y = greedy ? other : preferred;
+		}
+
+		bool emit(const regex_node &node)
+		{
+			if(program.size() > max_program)
+			{
+				return false;
+			}
+			switch(node.kind)
+			{
+				case regex_node::empty:
+					return true;
+				case regex_node::chr:
+					emit(regex_automaton::opcode::chr, node.value);
+					return true;
+				case regex_node::set:
+					emit(regex_automaton::opcode::set, node.value);
+					return true;
+				case regex_node::any:
+					emit(regex_automaton::opcode::any);
+					return true;
+				case regex_node::bol:
+					emit(regex_automaton::opcode::bol);
+					return true;
+				case regex_node::eol:
+					emit(regex_automaton::opcode::eol);
+					return true;
+				case regex_node::group:
+					emit(regex_automaton::opcode::save, node.value * 2);
+					if(!emit(*node.children[0])) return false;
+					emit(regex_automaton::opcode::save, node.value * 2 + 1);
+					return true;
+				case regex_node::concat:
+					for(const auto &child : node.children)
+					{
+						if(!emit(*child)) return false;
+					}
+					return true;
+				case regex_node::alt:
+				{
+					std::vector<size_t> jumps;
+					for(size_t i = 0; i + 1 < node.children.size(); i++)
+					{
+						size_t fork = emit(regex_automaton::opcode::split);
+						if(!emit(*node.children[i])) return false;
+						jumps.push_back(emit(regex_automaton::opcode::jump));
+						split(fork, fork + 1, program.size(), true);
+					}
+					if(!emit(*node.children.back())) return false;
+					for(size_t jump : jumps)
+					{
+						program[jump].x = program.size();
+					}
+					return true;
+				}
+				case regex_node::repeat:
+				{
+					const auto &body = *node.children[0];
+					for(size_t i = 0; i < node.min; i++)
+					{
+						if(!emit(body)) return false;
+					}
+					if(node.max == regex_node::unbounded)
+					{
+						size_t fork = emit(regex_automaton::opcode::split);
+						if(!emit(body)) return false;
+						emit(regex_automaton::opcode::jump, 0, fork);
+						split(fork, fork + 1, program.size(), node.greedy);
+					}else{
+						std::vector<size_t> forks;
+						for(size_t i = node.min; i < node.max; i++)
+						{
+							forks.push_back(emit(regex_automaton::opcode::split));
+							if(!emit(body)) return false;
+						}
+						for(size_t fork : forks)
+						{
+							split(fork, fork + 1, program.size(), node.greedy);
+						}
+					}
+					return true;
+				}
+			}
+			return false;
+		}
+	};
+}
+
+std::unique_ptr<regex_automaton> regex_automaton::compile(const cell *begin, const cell *end, bool icase, bool nosubs)
+{
+	std::unique_ptr<regex_automaton> automaton(new regex_automaton());
+	regex_parser parser(begin, end, icase, nosubs, automaton->sets);
+	auto node = parser.parse();
+	if(!node)
+	{
+		return nullptr;
+	}
+	automaton->marks = parser.groups;
+	regex_emitter emitter(automaton->program);
+	emitter.emit(opcode::save, 0);
+	if(!emitter.emit(*node))
+	{
+		return nullptr;
+	}
+	emitter.emit(opcode::save, 1);
+	emitter.emit(opcode::match);
+
+	size_t size = sizeof(regex_automaton) + automaton->program.capacity() * sizeof(instruction);
+	for(const auto &set : automaton->sets)
+	{
+		size += sizeof(char_set) + set.high.capacity() * sizeof(std::pair<cell, cell>);
+	}
+	automaton->program_size = size;
+	return automaton;
+}
+
+void regex_automaton::thread_list::init(size_t states, size_t ncap)
+{
+	dense.resize(states);
+	sparse.resize(states);
+	caps.resize(states * ncap);
+	size = 0;
+}
+
+// Adds the thread and all threads reachable from it without consuming input, in the order of their priority.
+void regex_automaton::add_thread(search_context &ctx, thread_list &list, size_t pc, std::ptrdiff_t *caps, std::ptrdiff_t pos, bool bol, bool eol) const
+{
+	size_t ncap = marks * 2 + 2;
+	auto &stack = ctx.stack;
+	stack.clear();
+	stack.push_back({pc, static_cast<size_t>(-1), 0});
+	while(!stack.empty())
+	{
+		frame f = stack.back();
+		stack.pop_back();
+		if(f.slot != static_cast<size_t>(-1))
+		{
+			caps[f.slot] = f.value;
+			continue;
+		}
+		pc = f.pc;
+		bool follow = true;
+		while(follow && !list.contains(pc))
+		{
+			size_t index = list.insert(pc);
+			const auto &ins = program[pc];
+			switch(ins.op)
+			{
+				case opcode::jump:
+					pc = ins.x;
+					break;
+				case opcode::split:
+					stack.push_back({ins.y, static_cast<size_t>(-1), 0});
+					pc = ins.x;
+					break;
+				case opcode::save:
+					stack.push_back({0, static_cast<size_t>(ins.value), caps[ins.value]});
+					caps[ins.value] = pos;
+					pc++;
+					break;
+				case opcode::bol:
+					follow = bol;
+					pc++;
+					break;
+				case opcode::eol:
+					follow = eol;
+					pc++;
+					break;
+				default:
+					std::copy(caps, caps + ncap, list.caps.begin() + index * ncap);
+					follow = false;
+					break;
+			}
+		}
+	}
+}
+
+// Collects the instructions that consume input or finish the match, reachable from pc.
+// Unsatisfied $ assertions are kept, so that they can be resumed at the end of the input.
+void regex_automaton::closure(search_context &ctx, size_t pc, bool bol, bool eol, std::vector<size_t> &out) const
+{
+	auto &visited = ctx.visited;
+	auto &visit_stamp = ctx.visit_stamp;
+	if(++visit_stamp == 0)
+	{
+		std::fill(visited.begin(), visited.end(), 0);
+		visit_stamp = 1;
+	}
+	auto &stack = ctx.stack;
+	stack.clear();
+	stack.push_back({pc, static_cast<size_t>(-1), 0});
+	while(!stack.empty())
+	{
+		pc = stack.back().pc;
+		stack.pop_back();
+		while(visited[pc] != visit_stamp)
+		{
+			visited[pc] = visit_stamp;
+			const auto &ins = program[pc];
+			if(ins.op == opcode::jump)
+			{
+				pc = ins.x;
+			}else if(ins.op == opcode::split)
+			{
+				stack.push_back({ins.y, static_cast<size_t>(-1), 0});
+				pc = ins.x;
+			}else if(ins.op == opcode::save || (ins.op == opcode::bol && bol) || (ins.op == opcode::eol && eol))
+			{
+				pc++;
+			}else{
+				if(ins.op != opcode::bol)
+				{
+					out.push_back(pc);
+				}
+				break;
+			}
+		}
+	}
+}
+
+int regex_automaton::dfa_state_for(std::vector<size_t> &&pcs) const
+{
+	std::sort(pcs.begin(), pcs.end());
+	pcs.erase(std::unique(pcs.begin(), pcs.end()), pcs.end());
+	auto it = dfa_index.find(pcs);
+	if(it != dfa_index.end())
+	{
+		return it->second;
+	}
+	if(dfa_states.size() >= max_dfa_states)
+	{
+		return -1;
+	}
+	std::unique_ptr<dfa_state> state(new dfa_state());
+	for(size_t pc : pcs)
+	{
+		if(program[pc].op == opcode::match)
+		{
+			state->accepting = true;
+		}else if(program[pc].op == opcode::eol)
+		{
+			state->has_eol = true;
+		}
+	}
+	std::fill(std::begin(state->next), std::end(state->next), -2);
+	state->pcs = pcs;
+	// the set of positions is stored both in the state and in the index
+	dfa_size.fetch_add(sizeof(dfa_state) + 2 * pcs.size() * sizeof(size_t) + 4 * sizeof(void*), std::memory_order_relaxed);
+	int index = static_cast<int>(dfa_states.size());
+	dfa_states.push_back(std::move(state));
+	dfa_index.emplace(std::move(pcs), index);
+	return index;
+}
+
+// Moves all threads of the state over c, and starts a new search at the next position.
+int regex_automaton::dfa_step(search_context &ctx, int state, cell c) const
+{
+	bool cached = static_cast<ucell>(c) < 256;
+	if(cached)
+	{
+		int next = dfa_states[state]->next[c];
+		if(next != -2)
+		{
+			return next;
+		}
+	}
+	std::vector<size_t> pcs;
+	for(size_t pc : dfa_states[state]->pcs)
+	{
+		if(accepts(program[pc], c))
+		{
+			closure(ctx, pc + 1, false, false, pcs);
+		}
+	}
+	closure(ctx, 0, false, false, pcs);
+	int next = dfa_state_for(std::move(pcs));
+	if(cached && next >= 0)
+	{
+		dfa_states[state]->next[c] = next;
+	}
+	return next;
+}
+
+// Returns 1 if there is a match in the input, 0 if there is none, or -1 if the cache is full.
+int regex_automaton::dfa_search(search_context &ctx, const cell *begin, const cell *end, unsigned flags) const
+{
+	bool bol = !(flags & (match_not_bol | match_prev_avail));
+	int &start = dfa_start[bol];
+	if(start < 0)
+	{
+		std::vector<size_t> pcs;
+		closure(ctx, 0, bol, false, pcs);
+		start = dfa_state_for(std::move(pcs));
+		if(start < 0)
+		{
+			return -1;
+		}
+	}
+	int state = start;
+	for(const cell *it = begin; it != end; ++it)
+	{
+		if(dfa_states[state]->accepting)
+		{
+			return 1;
+		}
+		state = dfa_step(ctx, state, *it);
+		if(state < 0)
+		{
+			return -1;
+		}
+	}
+	const auto &last = *dfa_states[state];
+	if(last.accepting)
+	{
+		return 1;
+	}
+	if(last.has_eol && !(flags & match_not_eol))
+	{
+		std::vector<size_t> pcs;
+		for(size_t pc : last.pcs)
+		{
+			if(program[pc].op == opcode::eol)
+			{
+				closure(ctx, pc, bol && begin == end, true, pcs);
+			}
+		}
+		for(size_t pc : pcs)
+		{
+			if(program[pc].op == opcode::match)
+			{
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
+
+bool regex_automaton::search(const cell *begin, const cell *end, unsigned flags, std::vector<std::ptrdiff_t> &groups) const
+{
+	static thread_local search_context ctx;
+	if(ctx.visited.size() < program.size())
+	{
+		// stamps are never reused, so the marks left by other automata are harmless
+		ctx.visited.resize(program.size(), 0);
+	}
+
+	if(!(flags & (match_not_null | match_continuous)))
+	{
+		std::lock_guard<std::mutex> lock(dfa_mutex);
+		int found = dfa_search(ctx, begin, end, flags);
+		if(found == 0)
+		{
+			return false;
+		}else if(found < 0)
+		{
+			dfa_states.clear();
+			dfa_index.clear();
+			dfa_start[0] = dfa_start[1] = -1;
+			dfa_size.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	size_t ncap = marks * 2 + 2;
+	auto &clist = ctx.clist;
+	auto &nlist = ctx.nlist;
+	auto &work = ctx.work;
+	clist.init(program.size(), ncap);
+	nlist.init(program.size(), ncap);
+	work.resize(ncap);
+
+	bool matched = false;
+	std::ptrdiff_t length = end - begin;
+	for(std::ptrdiff_t pos = 0; ; pos++)
+	{
+		if(!matched && (pos == 0 || !(flags & match_continuous)))
+		{
+			std::fill(work.begin(), work.end(), -1);
+			bool bol = pos == 0 && !(flags & (match_not_bol | match_prev_avail));
+			bool eol = pos == length && !(flags & match_not_eol);
+			add_thread(ctx, clist, 0, work.data(), pos, bol, eol);
+		}
+		if(clist.size == 0)
+		{
+			break;
+		}
+		nlist.size = 0;
+		bool next_eol = pos + 1 == length && !(flags & match_not_eol);
+		for(size_t i = 0; i < clist.size; i++)
+		{
+			const auto &ins = program[clist.dense[i]];
+			std::ptrdiff_t *caps = clist.caps.data() + i * ncap;
+			if(ins.op == opcode::match)
+			{
+				if((flags & match_not_null) && caps[0] == pos)
+				{
+					continue;
+				}
+				matched = true;
+				groups.assign(caps, caps + ncap);
+				break;
+			}else if(pos < length && accepts(ins, begin[pos]))
+			{
+				add_thread(ctx, nlist, clist.dense[i] + 1, caps, pos + 1, false, next_eol);
+			}
+		}
+		if(pos == length)
+		{
+			break;
+		}
+		std::swap(clist, nlist);
+	}
+	return matched;
+}
@@ -0,0 +1,175 @@
+#ifndef REGEX_AUTOMATON_H_INCLUDED
+#define REGEX_AUTOMATON_H_INCLUDED
+
+#include "sdk/amx/amx.h"
+#include <vector>
+#include <bitset>
+#include <memory>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <cstddef>
+
+namespace strings
+{
+	// Regular expression compiled to a Thompson NFA, matched in time linear in the length of the input.
+	// Only the ECMAScript grammar is supported, without backreferences, assertions other than ^ and $, and class escapes;
+	// compile returns nullptr for other patterns, which should be handled by std::regex.
+	class regex_automaton
+	{
+	public:
+		enum match_flags
+		{
+			match_not_bol = 1,
+			match_not_eol = 2,
+			match_prev_avail = 4,
+			match_not_null = 8,
+			match_continuous = 16
+		};
+
+		enum class opcode : unsigned char
+		{
+			chr, set, any, split, jump, save, bol, eol, match
+		};
+
+		struct instruction
+		{
+			opcode op;
+			cell value;
+			size_t x;
+			size_t y;
+		};
+
+		struct char_set
+		{
+			std::bitset<256> low;
+			std::vector<std::pair<cell, cell>> high;
+			bool negated = false;
+
+			bool contains(cell c) const
+			{
+				if(static_cast<ucell>(c) < 256)
+				{
+					return low[c];
+				}
+				for(const auto &range : high)
+				{
+					if(range.first <= c && c <= range.second)
+					{
+						return !negated;
+					}
+				}
+				return negated;
+			}
+		};
+
+	private:
+		struct thread_list
+		{
+			std::vector<size_t> dense;
+			std::vector<size_t> sparse;
+			std::vector<std::ptrdiff_t> caps;
+			size_t size = 0;
+
+			void init(size_t states, size_t ncap);
+
+			bool contains(size_t pc) const
+			{
+				size_t i = sparse[pc];
+				return i < size && dense[i] == pc;
+			}
+
+			size_t insert(size_t pc)
+			{
+				sparse[pc] = size;
+				dense[size] = pc;
+				return size++;
+			}
+		};
+
+		struct frame
+		{
+			size_t pc;
+			size_t slot;
+			std::ptrdiff_t value;
+		};
+
+		// scratch space of one search, kept per thread so that a shared automaton can be searched concurrently
+		struct search_context
+		{
+			thread_list clist, nlist;
+			std::vector<frame> stack;
+			std::vector<std::ptrdiff_t> work;
+			std::vector<unsigned> visited;
+			unsigned visit_stamp = 0;
+		};
+
+		struct dfa_state
+		{
+			std::vector<size_t> pcs;
+			bool accepting = false;
+			bool has_eol = false;
+			int next[256];
+		};
+
+		static constexpr size_t max_dfa_states = 1024;
+
+		std::vector<instruction> program;
+		std::vector<char_set> sets;
+		size_t marks = 0;
+		// size of the program, and of the DFA states built so far
+		size_t program_size = 0;
+		mutable std::atomic<size_t> dfa_size;
+
+		// guards the lazily built DFA
+		mutable std::mutex dfa_mutex;
+		mutable std::vector<std::unique_ptr<dfa_state>> dfa_states;
+		mutable std::map<std::vector<size_t>, int> dfa_index;
+		mutable int dfa_start[2] = {-1, -1};
+
+		bool accepts(const instruction &ins, cell c) const
+		{
+			switch(ins.op)
+			{
+				case opcode::chr:
+					return ins.value == c;
+				case opcode::set:
+					return sets[ins.value].contains(c);
+				case opcode::any:
+					return c != '\n' && c != '\r';
+				default:
+					return false;
+			}
+		}
+
+		void add_thread(search_context &ctx, thread_list &list, size_t pc, std::ptrdiff_t *caps, std::ptrdiff_t pos, bool bol, bool eol) const;
+		void closure(search_context &ctx, size_t pc, bool bol, bool eol, std::vector<size_t> &out) const;
+		int dfa_state_for(std::vector<size_t> &&pcs) const;
+		int dfa_step(search_context &ctx, int state, cell c) const;
+		int dfa_search(search_context &ctx, const cell *begin, const cell *end, unsigned flags) const;
+
+	public:
+		static std::unique_ptr<regex_automaton> compile(const cell *begin, const cell *end, bool icase, bool nosubs);
+
+		size_t mark_count() const
+		{
+			return marks;
+		}
+
+		regex_automaton() : dfa_size(0)
+		{
+
+		}
+
+		// approximate number of bytes used, including the part of the DFA built so far
+		size_t memory_size() const
+		{
+			return program_size + dfa_size.load(std::memory_order_relaxed);
+		}
+
+		// groups receives the start and end of every group relative to begin, or -1 for groups that did not participate
+		bool search(const cell *begin, const cell *end, unsigned flags, std::vector<std::ptrdiff_t> &groups) const;
+	};
+}
+
+#endif
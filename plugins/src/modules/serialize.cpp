@@ -17,9 +17,10 @@ bool serialize_value(cell value, tag_ptr tag, void(*binary_writer)(void*, const
 			}
 			binary_writer(binary_writer_cookie, &static_cast<const char&>(1), sizeof(char));
 			binary_writer(binary_writer_cookie, reinterpret_cast<const char*>(&static_cast<const cell&>(ptr->size())), sizeof(cell));
-			for(const auto &elem : *ptr)
+			dyn_object buffer;
+			for(size_t i = 0; i < ptr->size(); i++)
 			{
-				object_writer(object_writer_cookie, &elem);
+				object_writer(object_writer_cookie, &ptr->get(i, buffer));
 			}
 			return true;
 		}
@@ -82,7 +83,7 @@ bool deserialize_value(cell &value, tag_ptr tag, cell(*binary_reader)(void*, cha
 			{
 				cell size;
 				binary_reader(binary_reader_cookie, reinterpret_cast<char*>(&size), sizeof(cell));
-				auto &ptr = list_pool.add();
+				auto ptr = list_pool.add();
 				value = list_pool.get_id(ptr);
 				for(cell i = 0; i < size; i++)
 				{
@@ -104,7 +105,7 @@ bool deserialize_value(cell &value, tag_ptr tag, cell(*binary_reader)(void*, cha
 				binary_reader(binary_reader_cookie, reinterpret_cast<char*>(&size), sizeof(cell));
 				cell ordered;
 				binary_reader(binary_reader_cookie, reinterpret_cast<char*>(&ordered), sizeof(cell));
-				auto &ptr = map_pool.add();
+				auto ptr = map_pool.add();
 				value = map_pool.get_id(ptr);
 				ptr->set_ordered(ordered);
 				for(cell i = 0; i < size; i++)
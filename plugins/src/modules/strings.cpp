@@ -10,7 +10,7 @@
 
 using namespace strings;
 
-object_pool<cell_string> strings::pool;
+object_pool<cell_string> strings::pool(true);
 
 cell strings::null_value1[1] = {0};
 cell strings::null_value2[2] = {0, 1};
@@ -129,6 +129,7 @@ const std::ctype<cell> cell_ctype;
 
 std::locale custom_locale;
 std::string custom_locale_name;
+bool classic_numbers = true;
 
 std::locale::category get_category(cell category)
 {
@@ -172,6 +173,13 @@ void strings::set_locale(const std::locale &loc, cell category)
 	}
 	custom_locale_name = loc.name();
 	std::ctype<cell>::base_facet = &std::use_facet<std::ctype<char>>(custom_locale);
+	const auto &punct = std::use_facet<std::numpunct<char>>(custom_locale);
+	classic_numbers = punct.decimal_point() == '.' && punct.grouping().empty();
+}
+
+bool strings::numbers_classic()
+{
+	return classic_numbers;
 }
 
 const std::string &strings::locale_name()
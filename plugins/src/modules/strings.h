@@ -18,6 +18,7 @@ namespace strings
 	typedef std::basic_string<cell> cell_string;
 	extern cell null_value1[1];
 	extern cell null_value2[2];
+	// uses slot ids, so at most 2^22 (about 4M) strings can exist at the same time
 	extern object_pool<cell_string> pool;
 
 	namespace impl
@@ -302,6 +303,8 @@ namespace strings
 
 	void set_locale(const std::locale &loc, cell category);
 	const std::string &locale_name();
+	// true if numbers are formatted like in the C locale
+	bool numbers_classic();
 
 	cell to_lower(cell c);
 	cell to_upper(cell c);
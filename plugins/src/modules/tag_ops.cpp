@@ -1341,9 +1341,10 @@ struct list_operations : public generic_operations<list_operations, tags::tag_li
 			list_t tmp;
 			std::swap(*l, tmp);
 			list_t *l2 = list_pool.add().get();
-			for(auto &obj : tmp)
+			dyn_object buffer;
+			for(size_t i = 0; i < tmp.size(); i++)
 			{
-				l2->push_back(obj.clone());
+				l2->push_back(tmp.get(i, buffer).clone());
 			}
 			std::swap(*l, tmp);
 			return list_pool.get_id(l2);
@@ -5,12 +5,77 @@
 #include <unordered_map>
 #include <vector>
 #include <cstdint>
+#include <cstring>
 #include <memory>
 
 extern std::vector<std::unique_ptr<tag_info>> tag_list;
 
+// non-owning key referring to the name of a registered tag, or to a looked-up name
+struct tag_name_key
+{
+	const char *data;
+	size_t size;
+
+	bool operator==(const tag_name_key &other) const
+	{
+		return size == other.size && std::memcmp(data, other.data, size) == 0;
+	}
+};
+
+struct tag_name_hash
+{
+	size_t operator()(const tag_name_key &key) const
+	{
+		size_t hash = 2166136261u;
+		for(size_t i = 0; i < key.size; i++)
+		{
+			hash = (hash ^ static_cast<unsigned char>(key.data[i])) * 16777619u;
+		}
+		return hash;
+	}
+};
+
+typedef std::unordered_map<tag_name_key, tag_ptr, tag_name_hash> tag_index_map;
+
+static tag_index_map &tag_index()
+{
+	// built on first use, since tag_list is initialized in another translation unit
+	static tag_index_map index([]()
+	{
+		tag_index_map map;
+		for(auto &tag : ::tag_list)
+		{
+			if(tag) map.emplace(tag_name_key{tag->name.data(), tag->name.size()}, tag.get());
+		}
+		return map;
+	}());
+	return index;
+}
+
+static tag_ptr find_indexed_tag(const char *name, size_t sublen)
+{
+	auto &index = tag_index();
+	auto it = index.find(tag_name_key{name, sublen == -1 ? std::strlen(name) : sublen});
+	if(it != index.end())
+	{
+		return it->second;
+	}
+	return nullptr;
+}
+
+static tag_ptr register_tag(std::unique_ptr<tag_info> &&tag)
+{
+	auto &index = tag_index();
+	auto ptr = tag.get();
+	::tag_list[ptr->uid] = std::move(tag);
+	index.emplace(tag_name_key{ptr->name.data(), ptr->name.size()}, ptr);
+	return ptr;
+}
+
 struct tag_map_info : public amx::extra
 {
+	static constexpr amx::extra_slot slot = amx::extra_slot::tag_map;
+
 	std::unordered_map<cell, tag_ptr> tag_map;
 
 	tag_map_info(AMX *amx) : amx::extra(amx)
@@ -33,12 +98,11 @@ struct tag_map_info : public amx::extra
 
 tag_ptr tags::find_tag(const char *name, size_t sublen)
 {
-	std::string tag_name = sublen == -1 ? std::string(name) : std::string(name, sublen);
-
-	for(auto &tag : ::tag_list)
+	if(auto tag = find_indexed_tag(name, sublen))
 	{
-		if(tag && tag->name == tag_name) return tag.get();
+		return tag;
 	}
+	std::string tag_name = sublen == -1 ? std::string(name) : std::string(name, sublen);
 
 	size_t pos = std::string::npos, npos = -1;
 	while(true)
@@ -61,19 +125,15 @@ tag_ptr tags::find_tag(const char *name, size_t sublen)
 	::tag_list.push_back(nullptr);
 
 	auto ops = base->get_ops().derive(base, id, tag_name.c_str());
-	::tag_list[id] = std::make_unique<tag_info>(id, std::move(tag_name), base, std::move(ops));
-	return ::tag_list[id].get();
+	return register_tag(std::make_unique<tag_info>(id, std::move(tag_name), base, std::move(ops)));
 }
 
 tag_ptr tags::find_existing_tag(const char *name, size_t sublen)
 {
-	std::string tag_name = sublen == -1 ? std::string(name) : std::string(name, sublen);
-
-	for(auto &tag : ::tag_list)
+	if(auto tag = find_indexed_tag(name, sublen))
 	{
-		if(tag && tag->name == tag_name) return tag.get();
+		return tag;
 	}
-
 	return ::tag_list[tag_unknown].get();
 }
 
@@ -128,13 +188,11 @@ tag_ptr tags::new_tag(const char *name, cell base_id)
 	auto ops = base->get_ops().derive(base, id, tag_name.c_str());
 	auto tag = std::make_unique<tag_info>(id, std::move(tag_name), base, std::move(ops));
 	tag->name.append(std::to_string(reinterpret_cast<std::uintptr_t>(tag.get())));
-	while(find_existing_tag(tag->name.c_str())->uid != tag_unknown)
+	while(find_indexed_tag(tag->name.data(), tag->name.size()))
 	{
 		tag->name.append(1, '_');
 	}
-	auto ptr = tag.get();
-	::tag_list[id] = std::move(tag);
-	return ptr;
+	return register_tag(std::move(tag));
 }
 
 tag_info::tag_info(cell uid, std::string &&name, tag_ptr base, std::unique_ptr<tag_operations> &&ops) : uid(uid), name(std::move(name)), base(base), ops(std::move(ops))
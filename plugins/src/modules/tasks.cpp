@@ -2,10 +2,10 @@
 #include "exec.h"
 
 #include "utils/shared_id_set_pool.h"
+#include "utils/timing_wheel.h"
 #include "sdk/amx/amx.h"
 #include <utility>
 #include <chrono>
-#include <list>
 #include <unordered_set>
 #include <queue>
 
@@ -76,8 +76,13 @@ namespace tasks
 	aux::shared_id_set_pool<task> pool;
 
 	ucell tick_count = 0;
-	std::list<std::pair<ucell, std::unique_ptr<handler>>> tick_handlers;
-	std::list<std::pair<std::chrono::system_clock::time_point, std::unique_ptr<handler>>> timer_handlers;
+	aux::timing_wheel<std::unique_ptr<handler>> tick_handlers;
+	aux::timing_wheel<std::unique_ptr<handler>> timer_handlers;
+
+	// timers are keyed by milliseconds elapsed since this point
+	const auto timer_epoch = std::chrono::steady_clock::now();
+	std::chrono::steady_clock::time_point tick_time = timer_epoch;
+	timer_clock clock_mode = timer_clock::exact;
 
 	std::queue<std::unique_ptr<handler>> pending_handlers;
 
@@ -229,18 +234,28 @@ namespace tasks
 		handlers.erase(it);
 	}
 
-	template <class Ord, class Obj>
-	typename std::list<std::pair<Ord, Obj>>::iterator insert_sorted(std::list<std::pair<Ord, Obj>> &list, const Ord &ord, Obj &&obj)
+	typedef aux::timing_wheel<std::unique_ptr<handler>>::key_type timer_key;
+
+	static timer_key timer_time(std::chrono::steady_clock::time_point time, bool round_up)
 	{
-		for(auto it = list.begin();; it++)
+		auto elapsed = time - timer_epoch;
+		auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed);
+		timer_key key = ms.count();
+		if(round_up && ms < elapsed)
 		{
-			if(it == list.end() || it->first > ord)
-			{
-				return list.insert(it, std::make_pair(ord, std::forward<Obj>(obj)));
-			}
+			key++;
 		}
+		return key;
 	}
-	
+
+	static void insert_timer(cell interval, std::unique_ptr<handler> &&handler)
+	{
+		// in coarse mode, the time of the last tick is used instead of querying the clock
+		auto now = clock_mode == timer_clock::coarse ? tick_time : std::chrono::steady_clock::now();
+		// rounded up so that the timer is never completed before the interval elapses
+		timer_handlers.insert(timer_time(now, true) + (ucell)interval, std::move(handler));
+	}
+
 	std::shared_ptr<task> add_tick_task(cell ticks)
 	{
 		auto task = add();
@@ -260,7 +275,7 @@ namespace tasks
 		if(ticks > 0)
 		{
 			ucell time = tick_count + (ucell)ticks;
-			insert_sorted(tick_handlers, time, std::move(handler));
+			tick_handlers.insert(time, std::move(handler));
 		}else if(ticks == 0)
 		{
 			pending_handlers.push(std::move(handler));
@@ -271,8 +286,7 @@ namespace tasks
 	{
 		if(interval > 0)
 		{
-			auto time = std::chrono::system_clock::now() + std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::milliseconds(interval));
-			insert_sorted(timer_handlers, time, std::move(handler));
+			insert_timer(interval, std::move(handler));
 		}else if(interval == 0)
 		{
 			pending_handlers.push(std::move(handler));
@@ -344,7 +358,7 @@ namespace tasks
 		if(ticks > 0)
 		{
 			ucell time = tick_count + (ucell)ticks;
-			insert_sorted(tick_handlers, time, std::unique_ptr<handler>(new reset_handler(std::move(reset))));
+			tick_handlers.insert(time, std::unique_ptr<handler>(new reset_handler(std::move(reset))));
 		}else if(ticks == 0)
 		{
 			pending_handlers.push(std::unique_ptr<handler>(new reset_handler(std::move(reset))));
@@ -355,8 +369,7 @@ namespace tasks
 	{
 		if(interval > 0)
 		{
-			auto time = std::chrono::system_clock::now() + std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::milliseconds(interval));
-			insert_sorted(timer_handlers, time, std::unique_ptr<handler>(new reset_handler(std::move(reset))));
+			insert_timer(interval, std::unique_ptr<handler>(new reset_handler(std::move(reset))));
 		}else if(interval == 0)
 		{
 			pending_handlers.push(std::unique_ptr<handler>(new reset_handler(std::move(reset))));
@@ -385,45 +398,30 @@ namespace tasks
 
 	void tick()
 	{
+		// sampled first, so that timers started by the resumed tick tasks already use the time of this tick
+		tick_time = std::chrono::steady_clock::now();
 		tick_count++;
+		tick_handlers.advance(tick_count, [](std::unique_ptr<handler> &&handler)
 		{
-			auto it = tick_handlers.begin();
-			while(it != tick_handlers.end())
-			{
-				auto &pair = *it;
-
-				if(pair.first <= tick_count)
-				{
-					auto handler = std::move(pair.second);
-					it = tick_handlers.erase(it);
-					handler->set_completed(auto_result());
-				}else{
-					break;
-				}
-			}
-		}
+			handler->set_completed(auto_result());
+		});
 		if(tick_handlers.empty())
 		{
 			tick_count = 0;
+			tick_handlers.rewind(0);
 		}
 
-		auto now = std::chrono::system_clock::now();
+		timer_handlers.advance(timer_time(tick_time, false), [](std::unique_ptr<handler> &&handler)
 		{
-			auto it = timer_handlers.begin();
-			while(it != timer_handlers.end())
-			{
-				auto &pair = *it;
-
-				if(pair.first <= now)
-				{
-					auto handler = std::move(pair.second);
-					it = timer_handlers.erase(it);
-					handler->set_completed(auto_result());
-				}else{
-					break;
-				}
-			}
-		}
+			handler->set_completed(auto_result());
+		});
+	}
+
+	timer_clock set_timer_clock(timer_clock clock)
+	{
+		auto old = clock_mode;
+		clock_mode = clock;
+		return old;
 	}
 
 	void clear()
@@ -191,11 +191,15 @@ namespace tasks
 
 	struct extra : amx::extra
 	{
+		static constexpr amx::extra_slot slot = amx::extra_slot::tasks;
+
 		cell result = 0;
 		std::weak_ptr<task> awaited_task;
 		std::weak_ptr<task> bound_task;
 		amx::restore_range restore_heap = amx::restore_range::full;
 		amx::restore_range restore_stack = amx::restore_range::full;
+		// bytes of heap and stack captured by the last suspension
+		size_t captured_size = 0;
 
 		extra(AMX *amx) : amx::extra(amx)
 		{
@@ -205,6 +209,12 @@ namespace tasks
 		~extra();
 	};
 
+	enum class timer_clock
+	{
+		exact = 0,
+		coarse = 1
+	};
+
 	std::shared_ptr<task> add();
 	std::shared_ptr<task> add_tick_task(cell ticks);
 	std::shared_ptr<task> add_timer_task(cell interval);
@@ -229,6 +239,7 @@ namespace tasks
 
 	void tick();
 	size_t size();
+	timer_clock set_timer_clock(timer_clock clock);
 
 	extra &get_extra(AMX *amx, amx::object &owner);
 }
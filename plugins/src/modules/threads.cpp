@@ -4,26 +4,121 @@
 #include "objects/reset.h"
 #include "modules/tasks.h"
 #include "utils/thread.h"
+#include "utils/mpsc_ring.h"
 
-#include <unordered_map>
+#include <vector>
+#include <algorithm>
 #include <mutex>
 #include <condition_variable>
 #include <tuple>
 #include <limits>
-#include <queue>
 #include <atomic>
 #include <memory>
+#include <chrono>
+#include <thread>
 
 class thread_state;
-extern std::unordered_multimap<AMX*, thread_state*> running_threads;
 thread_local thread_state *my_instance;
 
+// Thread running detached code, kept after the code is attached and reused for the next detach
+class detach_worker
+{
+	std::mutex mutex;
+	std::condition_variable job_ready;
+	thread_state *job = nullptr;
+	bool stopping = false;
+	std::atomic<bool> finished;
+	aux::thread thread;
+
+	void run();
+
+public:
+	detach_worker *next_idle = nullptr;
+
+	detach_worker() : finished(false), thread([=]() { run(); })
+	{
+		thread.keep_joinable();
+		thread.start();
+	}
+
+	detach_worker(const detach_worker&) = delete;
+	detach_worker &operator=(const detach_worker&) = delete;
+
+	~detach_worker()
+	{
+		stop();
+		thread.join();
+	}
+
+	// true when the thread is about to end, so joining it does not block
+	bool is_finished() const
+	{
+		return finished.load(std::memory_order_acquire);
+	}
+
+	void start(thread_state *state)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		job = state;
+		job_ready.notify_one();
+	}
+
+	void stop()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+		job_ready.notify_one();
+	}
+
+	// lets the thread run on its own; the instance must then never be destroyed
+	void abandon()
+	{
+		thread.detach();
+	}
+
+	void pause()
+	{
+		thread.pause();
+	}
+
+	void resume()
+	{
+		thread.resume();
+	}
+};
+
+// Idle workers, pushed by the workers themselves and taken only by the main thread
+static std::atomic<detach_worker*> idle_workers(nullptr);
+// all workers, owned and modified only by the main thread
+static std::vector<std::unique_ptr<detach_worker>> workers;
+static size_t max_workers = 4;
+
+static void push_idle_worker(detach_worker *worker)
+{
+	detach_worker *head = idle_workers.load(std::memory_order_relaxed);
+	do{
+		worker->next_idle = head;
+	}while(!idle_workers.compare_exchange_weak(head, worker, std::memory_order_release, std::memory_order_relaxed));
+}
+
+static detach_worker *pop_idle_worker()
+{
+	// there is only one consumer, so a popped worker cannot reappear in the meantime
+	detach_worker *head = idle_workers.load(std::memory_order_acquire);
+	while(head != nullptr && !idle_workers.compare_exchange_weak(head, head->next_idle, std::memory_order_acquire, std::memory_order_acquire))
+	{
+
+	}
+	return head;
+}
+
 class thread_state
 {
 	std::mutex mutex;
 	amx::reset reset;
 	amx::context original_context;
-	aux::thread thread;
+	detach_worker *worker;
+	std::unique_ptr<aux::thread> thread;
 	AMX_CALLBACK orig_callback;
 	AMX *amx;
 	Threads::SyncFlags flags;
@@ -34,6 +129,7 @@ class thread_state
 	volatile bool pending = false;
 	volatile bool attach = false;
 	volatile bool done = false;
+	volatile bool exited = false;
 	bool paused = false;
 	amx::object lock;
 
@@ -63,6 +159,7 @@ class thread_state
 		return my_instance->auto_callback(amx, index, result, params);
 	}
 
+public:
 	void run()
 	{
 		my_instance = this;
@@ -90,6 +187,9 @@ class thread_state
 				switch(amx->pri & SleepReturnTypeMask)
 				{
 					case SleepReturnAttach:
+					{
+						// under the lock, so that pause does not interrupt the worker after it is released
+						std::lock_guard<std::mutex> lock(mutex);
 						amx->callback = orig_callback;
 						amx->pri = 0;
 						amx->error = 0;
@@ -97,6 +197,7 @@ class thread_state
 						attach = true;
 						join_sync.notify_all();
 						return;
+					}
 					case SleepReturnSync:
 						amx->pri = 0;
 						amx->error = 0;
@@ -110,8 +211,12 @@ class thread_state
 						set_flags(static_cast<Threads::SyncFlags>(SleepReturnValueMask & amx->pri));
 						break;
 					default:
+					{
+						std::lock_guard<std::mutex> lock(mutex);
 						amx->callback = orig_callback;
+						exited = true;
 						return;
+					}
 				}
 				amx->hea = old_hea;
 				amx->stk = old_stk;
@@ -119,10 +224,12 @@ class thread_state
 		}
 	}
 
-public:
-	thread_state(AMX *amx) : amx(amx), lock(amx::load_lock(amx)), orig_callback(amx->callback), reset(amx, false),
-		thread([=]() { run(); })
+	thread_state(AMX *amx, detach_worker *worker) : amx(amx), lock(amx::load_lock(amx)), orig_callback(amx->callback), reset(amx, false), worker(worker)
 	{
+		if(!worker)
+		{
+			thread = std::unique_ptr<aux::thread>(new aux::thread([=]() { run(); }));
+		}
 		amx::object owner;
 		original_context = std::move(amx::get_context(amx, owner));
 	}
@@ -188,7 +295,12 @@ public:
 		if(!started)
 		{
 			std::unique_lock<std::mutex> lock(mutex);
-			thread.start();
+			if(worker)
+			{
+				worker->start(this);
+			}else{
+				thread->start();
+			}
 			join_sync.wait(lock);
 		}
 	}
@@ -211,12 +323,18 @@ public:
 
 	void pause()
 	{
-		if(started && !pending && !paused && !done && (flags & Threads::SyncFlags::SyncInterrupt) == Threads::SyncFlags::SyncInterrupt)
+		if(started && !pending && !paused && !attach && !exited && !done && (flags & Threads::SyncFlags::SyncInterrupt) == Threads::SyncFlags::SyncInterrupt)
 		{
 			std::lock_guard<std::mutex> lock(mutex);
-			if(paused || pending || done) return;
+			// an attached worker may already be running other code
+			if(paused || pending || attach || exited || done) return;
 
-			thread.pause();
+			if(worker)
+			{
+				worker->pause();
+			}else{
+				thread->pause();
+			}
 			amx->callback = orig_callback;
 			// might as well store paramcount
 			reset = amx::reset(amx, false);
@@ -243,112 +361,352 @@ public:
 				amx->callback = &amx_Callback;
 			}
 			paused = false;
-			thread.resume();
+			if(worker)
+			{
+				worker->resume();
+			}else{
+				thread->resume();
+			}
 		}
 	}
 };
 
-std::unordered_multimap<AMX*, thread_state*> running_threads;
+// Threads detached from one script
+struct thread_list : public amx::extra
+{
+	static constexpr amx::extra_slot slot = amx::extra_slot::threads;
+
+	// finished threads are replaced with nullptr and removed in SyncThreads
+	std::vector<thread_state*> threads;
+	bool active = false;
+
+	thread_list(AMX *amx) : amx::extra(amx)
+	{
+
+	}
+};
+
+// Scripts with any threads; the instance is kept alive until its list is removed
+static std::vector<std::pair<amx::object, thread_list*>> active_lists;
+
+static thread_list *find_threads(AMX *amx)
+{
+	for(const auto &pair : active_lists)
+	{
+		if(pair.first->get() == amx)
+		{
+			return pair.second;
+		}
+	}
+	return nullptr;
+}
+
+static void remove_finished_threads()
+{
+	auto last = std::remove_if(active_lists.begin(), active_lists.end(), [](const std::pair<amx::object, thread_list*> &pair)
+	{
+		auto &threads = pair.second->threads;
+		threads.erase(std::remove(threads.begin(), threads.end(), nullptr), threads.end());
+		if(threads.empty())
+		{
+			pair.second->active = false;
+			return true;
+		}
+		return false;
+	});
+	active_lists.erase(last, active_lists.end());
+}
+
+void detach_worker::run()
+{
+	while(true)
+	{
+		thread_state *state;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			while(!job && !stopping)
+			{
+				job_ready.wait(lock);
+			}
+			if(stopping)
+			{
+				break;
+			}
+			state = job;
+			job = nullptr;
+		}
+		state->run();
+		push_idle_worker(this);
+	}
+	finished.store(true, std::memory_order_release);
+}
+
+static void remove_worker(detach_worker *worker)
+{
+	// the destructor joins the thread
+	auto it = std::find_if(workers.begin(), workers.end(), [=](const std::unique_ptr<detach_worker> &ptr) { return ptr.get() == worker; });
+	if(it != workers.end())
+	{
+		workers.erase(it);
+	}
+}
 
 namespace Threads
 {
 	void DetachThread(AMX *amx, SyncFlags flags)
 	{
-		auto &state = *running_threads.emplace(amx, new thread_state(amx))->second;
-		state.set_flags(flags);
+		detach_worker *worker = pop_idle_worker();
+		while(worker && workers.size() > max_workers)
+		{
+			remove_worker(worker);
+			worker = pop_idle_worker();
+		}
+		if(!worker && workers.size() < max_workers)
+		{
+			workers.emplace_back(new detach_worker());
+			worker = workers.back().get();
+		}
+		// when all workers are busy, the code runs in its own thread
+		auto state = new thread_state(amx, worker);
+		state->set_flags(flags);
+
+		const auto &obj = amx::load_lock(amx);
+		auto &list = obj->get_extra<thread_list>();
+		list.threads.push_back(state);
+		if(!list.active)
+		{
+			list.active = true;
+			active_lists.emplace_back(obj, &list);
+		}
+	}
+
+	size_t SetMaxWorkers(size_t count)
+	{
+		size_t old = max_workers;
+		max_workers = count;
+		while(workers.size() > max_workers)
+		{
+			detach_worker *worker = pop_idle_worker();
+			if(!worker)
+			{
+				// busy workers are removed when they become idle
+				break;
+			}
+			remove_worker(worker);
+		}
+		return old;
+	}
+
+	void StopWorkers()
+	{
+		max_workers = 0;
+		for(const auto &worker : workers)
+		{
+			worker->stop();
+		}
+		// busy workers get some time to finish; their requests are not handled, since the scripts may be unloaded already
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+		while(true)
+		{
+			workers.erase(std::remove_if(workers.begin(), workers.end(), [](const std::unique_ptr<detach_worker> &worker) { return worker->is_finished(); }), workers.end());
+			if(workers.empty() || std::chrono::steady_clock::now() >= deadline)
+			{
+				break;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		// like any other detached thread, a worker still running its code is left alone
+		for(auto &worker : workers)
+		{
+			worker->abandon();
+			worker.release();
+		}
+		workers.clear();
+		idle_workers.store(nullptr, std::memory_order_relaxed);
 	}
 
 	void PauseThreads(AMX *amx)
 	{
-		auto bounds = running_threads.equal_range(amx);
-		for(auto it = bounds.first; it != bounds.second; it++)
+		if(active_lists.empty()) return;
+		if(auto list = find_threads(amx))
 		{
-			it->second->pause();
+			for(size_t i = 0; i < list->threads.size(); i++)
+			{
+				if(auto state = list->threads[i])
+				{
+					state->pause();
+				}
+			}
 		}
 	}
 
 	void ResumeThreads(AMX *amx)
 	{
-		auto bounds = running_threads.equal_range(amx);
-		for(auto it = bounds.first; it != bounds.second; it++)
+		if(active_lists.empty()) return;
+		if(auto list = find_threads(amx))
 		{
-			it->second->resume();
+			for(size_t i = 0; i < list->threads.size(); i++)
+			{
+				if(auto state = list->threads[i])
+				{
+					state->resume();
+				}
+			}
 		}
 	}
 
 	void JoinThreads(AMX *amx)
 	{
-		auto bounds = running_threads.equal_range(amx);
-		auto it = bounds.first;
-		while(it != bounds.second)
+		if(active_lists.empty()) return;
+		if(auto list = find_threads(amx))
 		{
-			if(it->second->join())
+			for(size_t i = 0; i < list->threads.size(); i++)
 			{
-				it = running_threads.erase(it);
-			}else{
-				it++;
+				auto state = list->threads[i];
+				if(state && state->join())
+				{
+					list->threads[i] = nullptr;
+				}
 			}
 		}
 	}
 
 	void StartThreads()
 	{
-		for(auto &thread : running_threads)
+		for(size_t i = 0; i < active_lists.size(); i++)
 		{
-			thread.second->start();
+			auto list = active_lists[i].second;
+			for(size_t j = 0; j < list->threads.size(); j++)
+			{
+				if(auto state = list->threads[j])
+				{
+					state->start();
+				}
+			}
 		}
 	}
 
-	std::queue<std::tuple<amx::reset, cell&, int&>> fix_queue;
-	std::mutex queue_mutex;
-	std::condition_variable queue_cond;
-	std::atomic_bool queue_signal(false);
-
-	void SyncThreads()
+	// Request from another thread to run code on the main thread, completed by SyncThreads
+	struct sync_request
 	{
-		auto it = running_threads.begin();
-		while(it != running_threads.end())
+		amx::reset reset;
+		cell &retval;
+		int &error;
+		std::chrono::steady_clock::time_point queued;
+		std::atomic<bool> done;
+		std::mutex mutex;
+		std::condition_variable completed;
+
+		sync_request(AMX *amx, cell &retval, int &error) : reset(amx, false), retval(retval), error(error), queued(std::chrono::steady_clock::now()), done(false)
+		{
+
+		}
+
+		void complete()
 		{
-			if(it->second->sync())
+			std::lock_guard<std::mutex> lock(mutex);
+			done.store(true, std::memory_order_release);
+			completed.notify_one();
+		}
+
+		void wait()
+		{
+			for(int i = 0; i < 64; i++)
 			{
-				it = running_threads.erase(it);
-			}else{
-				it++;
+				if(done.load(std::memory_order_acquire))
+				{
+					break;
+				}
+				std::this_thread::yield();
+			}
+			// always locked before returning, since complete may still be using the request after setting done
+			std::unique_lock<std::mutex> lock(mutex);
+			while(!done.load(std::memory_order_acquire))
+			{
+				completed.wait(lock);
 			}
 		}
+	};
+
+	aux::mpsc_ring<sync_request*, 256> sync_queue;
 
-		if(queue_signal)
+	// bucket i counts values in [2^(i-1), 2^i)
+	constexpr size_t sync_histogram_size = 16;
+	size_t sync_depths[sync_histogram_size];
+	std::atomic<size_t> sync_waits[sync_histogram_size];
+
+	static size_t histogram_bucket(size_t value)
+	{
+		size_t bucket = 0;
+		while(value != 0 && bucket < sync_histogram_size - 1)
 		{
-			std::unique_lock<std::mutex> lock(queue_mutex);
-			while(!fix_queue.empty())
-			{
-				auto tuple = std::move(fix_queue.front());
-				auto &reset = std::get<0>(tuple);
-				fix_queue.pop();
+			value >>= 1;
+			bucket++;
+		}
+		return bucket;
+	}
 
-				if(auto lock = reset.amx.lock())
+	void SyncThreads()
+	{
+		// the lists may grow or have threads removed while the code runs
+		for(size_t i = 0; i < active_lists.size(); i++)
+		{
+			auto list = active_lists[i].second;
+			for(size_t j = 0; j < list->threads.size(); j++)
+			{
+				auto state = list->threads[j];
+				if(state && state->sync())
 				{
-					AMX *amx = *lock;
-					int old_error = amx->error;
-					std::get<2>(tuple) = amx_ExecContext(amx, &std::get<1>(tuple), AMX_EXEC_CONT, true, &reset);
-					amx->error = old_error;
+					list->threads[j] = nullptr;
 				}
 			}
-			queue_signal = false;
-			queue_cond.notify_all();
+		}
+		remove_finished_threads();
+
+		size_t depth = 0;
+		sync_request *request;
+		// requests queued while handling these are left for the next tick
+		while(depth < sync_queue.capacity() && sync_queue.try_pop(request))
+		{
+			depth++;
+			auto &reset = request->reset;
+			if(auto lock = reset.amx.lock())
+			{
+				AMX *amx = *lock;
+				int old_error = amx->error;
+				request->error = amx_ExecContext(amx, &request->retval, AMX_EXEC_CONT, true, &reset);
+				amx->error = old_error;
+			}
+			request->complete();
+		}
+		if(depth > 0)
+		{
+			sync_depths[histogram_bucket(depth)]++;
 		}
 	}
 
 	void QueueAndWait(AMX *amx, cell &retval, int &error)
 	{
-		std::unique_lock<std::mutex> lock(queue_mutex);
-		fix_queue.emplace(amx::reset(amx, false), retval, error);
+		sync_request request(amx, retval, error);
 		amx->stk = amx->reset_stk;
 		amx->hea = amx->reset_hea;
-		queue_signal = true;
-		while(!fix_queue.empty())
+		while(!sync_queue.try_push(&request))
 		{
-			queue_cond.wait(lock);
+			std::this_thread::yield();
 		}
+		request.wait();
+		auto waited = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - request.queued).count();
+		sync_waits[histogram_bucket(static_cast<size_t>(waited))].fetch_add(1, std::memory_order_relaxed);
 	}
+
+	size_t GetSyncStats(cell *depths, cell *waits, size_t size)
+	{
+		for(size_t i = 0; i < size && i < sync_histogram_size; i++)
+		{
+			depths[i] = static_cast<cell>(sync_depths[i]);
+			waits[i] = static_cast<cell>(sync_waits[i].load(std::memory_order_relaxed));
+		}
+		return sync_queue.size();
+	}
+
 }
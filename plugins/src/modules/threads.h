@@ -21,6 +21,8 @@ namespace Threads
 	}
 
 	void DetachThread(AMX *amx, SyncFlags flags);
+	size_t SetMaxWorkers(size_t count);
+	void StopWorkers();
 	void PauseThreads(AMX *amx);
 	void ResumeThreads(AMX *amx);
 	void JoinThreads(AMX *amx);
@@ -28,6 +30,9 @@ namespace Threads
 	void SyncThreads();
 
 	void QueueAndWait(AMX *amx, cell &retval, int &error);
+	// fills power-of-two histograms of the number of requests handled per tick and their wait time in microseconds
+	// returns the number of requests waiting
+	size_t GetSyncStats(cell *depths, cell *waits, size_t size);
 }
 
 #endif
@@ -2,6 +2,7 @@
 #include "natives.h"
 #include "strings.h"
 #include "errors.h"
+#include "amxinfo.h"
 
 object_pool<dyn_object> variants::pool;
 
@@ -20,6 +21,54 @@ dyn_object dyn_func_str_s(AMX *amx, cell str)
 	return dyn_object(&str, 1, tags::find_tag(tags::tag_char));
 }
 
+struct string_key_cache : public amx::extra
+{
+	static constexpr amx::extra_slot slot = amx::extra_slot::string_keys;
+	static constexpr size_t size = 64;
+
+	struct entry
+	{
+		cell amx_addr = 0;
+		size_t hash = 0;
+		dyn_object key;
+	};
+
+	entry entries[size];
+
+	string_key_cache(AMX *amx) : amx::extra(amx)
+	{
+
+	}
+};
+
+dyn_object dyn_func_str_key(AMX *amx, cell amx_addr)
+{
+	cell *addr = amx_GetAddrSafe(amx, amx_addr);
+	cell size = dyn_object::string_size(addr);
+
+	size_t hash = 2166136261u;
+	for(cell i = 0; i < size; i++)
+	{
+		hash = (hash ^ static_cast<ucell>(addr[i])) * 16777619u;
+	}
+
+	auto obj = amx::load_lock(amx);
+	auto &cache = obj->get_extra<string_key_cache>();
+	auto &entry = cache.entries[(static_cast<size_t>(amx_addr) / sizeof(cell) ^ hash) % string_key_cache::size];
+	if(entry.amx_addr == amx_addr && entry.hash == hash && entry.key.is_interned())
+	{
+		const dyn_object &key = entry.key;
+		if(key.data_size() == size + 2 && !std::memcmp(key.data_begin(), addr, size * sizeof(cell)))
+		{
+			return key;
+		}
+	}
+	entry.amx_addr = amx_addr;
+	entry.hash = hash;
+	entry.key = dyn_object::intern(addr);
+	return entry.key;
+}
+
 cell *get_offsets(AMX *amx, cell offsets, cell &offsets_size)
 {
 	cell *offsets_addr = amx_GetAddrSafe(amx, offsets);
@@ -73,6 +73,7 @@ inline dyn_object dyn_func_str(AMX *amx, cell amx_addr)
 }
 
 dyn_object dyn_func_str_s(AMX *amx, cell str);
+dyn_object dyn_func_str_key(AMX *amx, cell amx_addr);
 
 inline dyn_object dyn_func_var(AMX *amx, cell ptr)
 {
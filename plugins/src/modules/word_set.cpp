@@ -0,0 +1,216 @@
+#include "word_set.h"
+#include "utils/cell_search.h"
+
+#include <algorithm>
+#include <map>
+
+using namespace strings;
+
+aux::shared_id_set_pool<word_set> strings::word_set_pool;
+
+word_set::word_set(const std::vector<cell_string> &list, bool ignore_case)
+{
+	cell fold[256];
+	for(cell c = 0; c < 256; c++)
+	{
+		fold[c] = ignore_case ? to_lower(c) : c;
+	}
+
+	// every distinct character in the words gets its own column in the table, and class 0 is for all other characters
+	std::fill(std::begin(low_class), std::end(low_class), 0);
+	std::map<cell, size_t> high;
+	std::vector<cell_string> folded;
+	folded.reserve(list.size());
+	for(const auto &word : list)
+	{
+		cell_string str(word);
+		for(auto &c : str)
+		{
+			if(static_cast<ucell>(c) < 256)
+			{
+				c = fold[c];
+				if(!low_class[c])
+				{
+					low_class[c] = classes++;
+				}
+			}else{
+				auto &cls = high[c];
+				if(!cls)
+				{
+					cls = classes++;
+				}
+			}
+		}
+		folded.push_back(std::move(str));
+	}
+	high_class.assign(high.begin(), high.end());
+
+	table.assign(classes, -1);
+	depth.push_back(0);
+	output.push_back(-1);
+	for(size_t i = 0; i < folded.size(); i++)
+	{
+		const auto &word = folded[i];
+		if(word.empty())
+		{
+			continue;
+		}
+		size_t node = 0;
+		for(cell c : word)
+		{
+			size_t cls = class_of(c);
+			int next = table[node * classes + cls];
+			if(next < 0)
+			{
+				next = static_cast<int>(depth.size());
+				table[node * classes + cls] = next;
+				table.resize(table.size() + classes, -1);
+				depth.push_back(depth[node] + 1);
+				output.push_back(-1);
+			}
+			node = next;
+		}
+		// the first of equal words is reported
+		if(output[node] < 0)
+		{
+			output[node] = static_cast<int>(words.size());
+			words.emplace_back(word.size(), i);
+		}
+	}
+
+	// replaces missing transitions with the ones of the failure state, so the input is read without backtracking
+	std::vector<int> fail(depth.size(), 0);
+	std::vector<size_t> queue;
+	table[0] = 0;
+	for(size_t cls = 1; cls < classes; cls++)
+	{
+		int &next = table[cls];
+		if(next < 0)
+		{
+			next = 0;
+		}else{
+			queue.push_back(next);
+		}
+	}
+	for(size_t i = 0; i < queue.size(); i++)
+	{
+		size_t node = queue[i];
+		int *row = &table[node * classes];
+		const int *fail_row = &table[fail[node] * classes];
+		row[0] = 0;
+		for(size_t cls = 1; cls < classes; cls++)
+		{
+			int next = row[cls];
+			if(next < 0)
+			{
+				row[cls] = fail_row[cls];
+			}else{
+				fail[next] = fail_row[cls];
+				// a state outputs the longest word that ends there
+				if(output[next] < 0)
+				{
+					output[next] = output[fail[next]];
+				}
+				queue.push_back(next);
+			}
+		}
+	}
+
+	// the input is matched as if it was folded
+	size_t folded_class[256];
+	std::copy(std::begin(low_class), std::end(low_class), std::begin(folded_class));
+	for(cell c = 0; c < 256; c++)
+	{
+		low_class[c] = folded_class[fold[c]];
+		low_start[c] = table[low_class[c]] != 0;
+		if(low_start[c])
+		{
+			start_values.push_back(c);
+		}
+	}
+	for(const auto &pair : high_class)
+	{
+		if(table[pair.second] != 0)
+		{
+			start_values.push_back(pair.first);
+		}
+	}
+	if(start_values.size() > aux::max_any_values)
+	{
+		start_values.clear();
+	}
+}
+
+size_t word_set::find_high_class(cell c) const
+{
+	auto it = std::lower_bound(high_class.begin(), high_class.end(), c, [](const std::pair<cell, size_t> &pair, cell c) {return pair.first < c; });
+	if(it != high_class.end() && it->first == c)
+	{
+		return it->second;
+	}
+	return 0;
+}
+
+// finds the next character that can start a word
+size_t word_set::skip(const cell *begin, size_t pos, size_t size) const
+{
+	if(!start_values.empty())
+	{
+		return pos + aux::find_any_cell(begin + pos, size - pos, start_values.data(), start_values.size());
+	}
+	while(pos < size)
+	{
+		cell c = begin[pos];
+		if(static_cast<ucell>(c) < 256 ? low_start[c] : table[find_high_class(c)] != 0)
+		{
+			break;
+		}
+		pos++;
+	}
+	return pos;
+}
+
+bool word_set::find(const cell *begin, size_t size, size_t offset, match &result) const
+{
+	if(words.empty())
+	{
+		return false;
+	}
+	bool found = false;
+	size_t state = 0;
+	for(size_t i = offset; i < size; i++)
+	{
+		if(state == 0)
+		{
+			if(found)
+			{
+				break;
+			}
+			i = skip(begin, i, size);
+			if(i == size)
+			{
+				break;
+			}
+		}
+		state = table[state * classes + class_of(begin[i])];
+		if(found && i + 1 - depth[state] > result.pos)
+		{
+			// no word that is still being matched started before the found one
+			break;
+		}
+		int word = output[state];
+		if(word >= 0)
+		{
+			size_t length = words[word].first;
+			size_t pos = i + 1 - length;
+			if(!found || pos < result.pos || (pos == result.pos && length > result.length))
+			{
+				result.pos = pos;
+				result.length = length;
+				result.index = words[word].second;
+				found = true;
+			}
+		}
+	}
+	return found;
+}
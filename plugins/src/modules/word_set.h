@@ -0,0 +1,62 @@
+#ifndef WORD_SET_H_INCLUDED
+#define WORD_SET_H_INCLUDED
+
+#include "modules/strings.h"
+#include "utils/shared_id_set_pool.h"
+#include "sdk/amx/amx.h"
+#include <vector>
+#include <utility>
+
+namespace strings
+{
+	// Set of literal words compiled to an Aho-Corasick automaton, so that all of them are found in a single pass.
+	class word_set
+	{
+	public:
+		struct match
+		{
+			size_t pos;
+			size_t length;
+			// position of the word in the original list
+			size_t index;
+		};
+
+	private:
+		std::vector<int> table;
+		std::vector<size_t> depth;
+		std::vector<int> output;
+		std::vector<std::pair<size_t, size_t>> words;
+		size_t classes = 1;
+		size_t low_class[256];
+		std::vector<std::pair<cell, size_t>> high_class;
+		bool low_start[256];
+		std::vector<cell> start_values;
+
+		size_t class_of(cell c) const
+		{
+			if(static_cast<ucell>(c) < 256)
+			{
+				return low_class[c];
+			}
+			return find_high_class(c);
+		}
+
+		size_t find_high_class(cell c) const;
+		size_t skip(const cell *begin, size_t pos, size_t size) const;
+
+	public:
+		word_set(const std::vector<cell_string> &list, bool ignore_case);
+
+		size_t size() const
+		{
+			return words.size();
+		}
+
+		// finds the leftmost match at or after offset, preferring the longest word at the same position
+		bool find(const cell *begin, size_t size, size_t offset, match &result) const;
+	};
+
+	extern aux::shared_id_set_pool<word_set> word_set_pool;
+}
+
+#endif
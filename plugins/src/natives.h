@@ -105,6 +105,8 @@ namespace impl
 
 struct native_error_level : public amx::extra
 {
+	static constexpr amx::extra_slot slot = amx::extra_slot::error_level;
+
 	int level = 2;
 
 	native_error_level(AMX *amx) : amx::extra(amx)
@@ -327,6 +327,12 @@ namespace Natives
 		return expr_unary<nested_expression>(amx, params);
 	}
 
+	// native Expression:expr_compile(Expression:expr);
+	AMX_DEFINE_NATIVE_TAG(expr_compile, 1, expression)
+	{
+		return expr_unary<compiled_expression>(amx, params);
+	}
+
 	// native Expression:expr_env();
 	AMX_DEFINE_NATIVE_TAG(expr_env, 0, expression)
 	{
@@ -857,6 +863,7 @@ static AMX_NATIVE_INFO native_list[] =
 	AMX_DECLARE_NATIVE(expr_arg_pack),
 	AMX_DECLARE_NATIVE(expr_bind),
 	AMX_DECLARE_NATIVE(expr_nested),
+	AMX_DECLARE_NATIVE(expr_compile),
 	AMX_DECLARE_NATIVE(expr_env),
 	AMX_DECLARE_NATIVE(expr_set_env),
 	AMX_DECLARE_NATIVE(expr_global),
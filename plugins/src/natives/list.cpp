@@ -3,10 +3,88 @@
 #include "modules/containers.h"
 #include "modules/variants.h"
 #include "modules/expressions.h"
+#include "utils/cell_search.h"
+#include "utils/parallel_sort.h"
 
 #include <vector>
 #include <algorithm>
 
+// gets the value to compare with the elements of a compact list, if they can be equal to it
+static bool compact_key(const list_t &list, const dyn_object &value, cell &key)
+{
+	tag_ptr tag = list.get_cell_tag();
+	if(tag == nullptr || !value.is_cell() || !tag->same_base(value.get_tag()))
+	{
+		return false;
+	}
+	key = *value.begin();
+	return true;
+}
+
+// parallel is only allowed if the comparison cannot call into a script
+template <class Iter, class Compare>
+static void sort_range(Iter begin, Iter end, Compare comp, bool stable, bool parallel)
+{
+	if(parallel && sort_workers.size() > 0 && static_cast<size_t>(end - begin) >= sort_parallel_threshold)
+	{
+		aux::parallel_sort(sort_workers, begin, end, comp, stable);
+	}else if(stable)
+	{
+		std::stable_sort(begin, end, comp);
+	}else{
+		std::sort(begin, end, comp);
+	}
+}
+
+// compares the cells like the corresponding dyn_object instances would be compared
+template <class Iter>
+static void sort_cells(Iter begin, Iter end, tag_ptr tag, bool stable)
+{
+	if(tag->uid == tags::tag_float || tag->uid == tags::tag_unsigned)
+	{
+		const auto &ops = tag->get_ops();
+		auto lt = [=, &ops](cell a, cell b)
+		{
+			return ops.lt(tag, a, b);
+		};
+		sort_range(begin, end, lt, stable, true);
+	}else{
+		// equal cells cannot be told apart
+		sort_range(begin, end, std::less<cell>(), false, true);
+	}
+}
+
+// removes the elements of a compact list for which pred returns true, passing them as dyn_object instances
+template <class Pred>
+static void erase_compact_if(list_t &list, Pred pred)
+{
+	auto &cells = list.get_cells();
+	tag_ptr tag = list.get_cell_tag();
+	dyn_object value;
+	cells.erase(std::remove_if(cells.begin(), cells.end(), [&](const cell &c)
+	{
+		value = dyn_object(c, tag);
+		return pred(value, &c - cells.data());
+	}), cells.end());
+}
+
+static bool has_plain_cell_tags(const list_t &list)
+{
+	if(list.is_compact())
+	{
+		return true;
+	}
+	dyn_object buffer;
+	for(size_t i = 0; i < list.size(); i++)
+	{
+		if(!is_plain_cell_tag(list.get(i, buffer).get_tag()))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
 template <size_t... Indices>
 class value_at
 {
@@ -31,7 +109,7 @@ public:
 			amx_LogicError(errors::out_of_range, "index");
 			return 0;
 		}else{
-			ptr->insert(ptr->begin() + index, Factory(amx, params[Indices]...));
+			ptr->insert(static_cast<size_t>(index), Factory(amx, params[Indices]...));
 			return index;
 		}
 	}
@@ -44,7 +122,7 @@ public:
 		list_t *ptr;
 		if(!list_pool.get_by_id(params[1], ptr)) amx_LogicError(errors::pointer_invalid, "list", params[1]);
 		if(static_cast<ucell>(params[2]) >= ptr->size()) amx_LogicError(errors::out_of_range, "index");
-		(*ptr)[params[2]] = Factory(amx, params[Indices]...);
+		ptr->set(params[2], Factory(amx, params[Indices]...));
 		return 1;
 	}
 
@@ -56,6 +134,10 @@ public:
 		list_t *ptr;
 		if(!list_pool.get_by_id(params[1], ptr)) amx_LogicError(errors::pointer_invalid, "list", params[1]);
 		if(static_cast<ucell>(params[2]) >= ptr->size()) amx_LogicError(errors::out_of_range, "index");
+		if(ptr->is_compact())
+		{
+			return Factory(amx, dyn_object(ptr->get_cells()[params[2]], ptr->get_cell_tag()), params[Indices]...);
+		}
 		return Factory(amx, (*ptr)[params[2]], params[Indices]...);
 	}
 	
@@ -74,6 +156,34 @@ public:
 		{
 			if(index < 0 || static_cast<ucell>(index) >= ptr->size()) amx_LogicError(errors::out_of_range, "index");
 			auto find = Factory(amx, params[Indices]...);
+			if(ptr->is_compact())
+			{
+				cell key;
+				if(compact_key(*ptr, find, key))
+				{
+					const auto &cells = ptr->get_cells();
+					tag_ptr tag = ptr->get_cell_tag();
+					if(has_bitwise_eq(tag))
+					{
+						size_t size = cells.size() - index;
+						size_t pos = aux::find_cell(cells.data() + index, size, key);
+						if(pos != size)
+						{
+							return static_cast<cell>(index + pos);
+						}
+					}else{
+						const auto &ops = tag->get_ops();
+						for(size_t i = static_cast<size_t>(index); i < cells.size(); i++)
+						{
+							if(ops.eq(tag, cells[i], key))
+							{
+								return static_cast<cell>(i);
+							}
+						}
+					}
+				}
+				return -1;
+			}
 			for(size_t i = static_cast<size_t>(index); i < ptr->size(); i++)
 			{
 				if((*ptr)[i] == find)
@@ -100,6 +210,35 @@ public:
 		{
 			if(index < 0 || static_cast<ucell>(index) >= ptr->size()) amx_LogicError(errors::out_of_range, "index");
 			auto find = Factory(amx, params[Indices]...);
+			if(ptr->is_compact())
+			{
+				cell key;
+				if(compact_key(*ptr, find, key))
+				{
+					const auto &cells = ptr->get_cells();
+					tag_ptr tag = ptr->get_cell_tag();
+					if(has_bitwise_eq(tag))
+					{
+						size_t size = static_cast<size_t>(index) + 1;
+						size_t pos = aux::find_last_cell(cells.data(), size, key);
+						if(pos != size)
+						{
+							return static_cast<cell>(pos);
+						}
+						return -1;
+					}
+					const auto &ops = tag->get_ops();
+					while(index >= 0)
+					{
+						if(ops.eq(tag, cells[index], key))
+						{
+							return index;
+						}
+						index--;
+					}
+				}
+				return -1;
+			}
 			while(index >= 0)
 			{
 				if((*ptr)[index] == find)
@@ -135,7 +274,27 @@ public:
 	{
 		list_t *ptr;
 		if(!list_pool.get_by_id(params[1], ptr)) amx_LogicError(errors::pointer_invalid, "list", params[1]);
-		return std::count(ptr->begin(), ptr->end(), Factory(amx, params[Indices]...));
+		auto find = Factory(amx, params[Indices]...);
+		if(ptr->is_compact())
+		{
+			cell key;
+			if(!compact_key(*ptr, find, key))
+			{
+				return 0;
+			}
+			const auto &cells = ptr->get_cells();
+			tag_ptr tag = ptr->get_cell_tag();
+			if(has_bitwise_eq(tag))
+			{
+				return static_cast<cell>(aux::count_cell(cells.data(), cells.size(), key));
+			}
+			const auto &ops = tag->get_ops();
+			return std::count_if(cells.begin(), cells.end(), [&](cell value)
+			{
+				return ops.eq(tag, value, key);
+			});
+		}
+		return std::count(ptr->begin(), ptr->end(), find);
 	}
 };
 
@@ -148,6 +307,15 @@ static cell AMX_NATIVE_CALL list_set_cell(AMX *amx, cell *params)
 	list_t *ptr;
 	if(!list_pool.get_by_id(params[1], ptr)) amx_LogicError(errors::pointer_invalid, "list", params[1]);
 	if(static_cast<ucell>(params[2]) >= ptr->size()) amx_LogicError(errors::out_of_range, "index");
+	if(ptr->is_compact())
+	{
+		// the tag stays the same, so the list can stay compact
+		dyn_object obj(ptr->get_cells()[params[2]], ptr->get_cell_tag());
+		if(TagIndex && !obj.tag_assignable(amx, params[TagIndex])) return 0;
+		obj.set_cell({params[3]}, params[4]);
+		ptr->set(params[2], std::move(obj));
+		return 1;
+	}
 	auto &obj = (*ptr)[params[2]];
 	if(TagIndex && !obj.tag_assignable(amx, params[TagIndex])) return 0;
 	obj.set_cell({params[3]}, params[4]);
@@ -446,7 +614,7 @@ namespace Natives
 		list_t *ptr;
 		if(!list_pool.get_by_id(params[1], ptr)) amx_LogicError(errors::pointer_invalid, "list", params[1]);
 		if(static_cast<ucell>(params[2]) >= ptr->size()) amx_LogicError(errors::out_of_range, "index");
-		ptr->erase(ptr->begin() + params[2]);
+		ptr->erase(params[2], params[2] + 1);
 		return 1;
 	}
 
@@ -458,9 +626,9 @@ namespace Natives
 		if(!list_pool.get_by_id(params[1], ptr)) amx_LogicError(errors::pointer_invalid, "list", params[1]);
 		if(static_cast<ucell>(params[2]) >= ptr->size()) amx_LogicError(errors::out_of_range, "index");
 
-		auto it = ptr->begin() + params[2];
-		it->release();
-		ptr->erase(it);
+		dyn_object buffer;
+		ptr->get(params[2], buffer).release();
+		ptr->erase(params[2], params[2] + 1);
 		return 1;
 	}
 
@@ -475,7 +643,7 @@ namespace Natives
 		ucell end = params[3];
 		if(begin >= ptr->size()) amx_LogicError(errors::out_of_range, "begin");
 		if(end >= ptr->size() || end < begin) amx_LogicError(errors::out_of_range, "end");
-		ptr->erase(ptr->begin() + params[2], ptr->begin() + params[3]);
+		ptr->erase(params[2], params[3]);
 		return 1;
 	}
 
@@ -490,11 +658,12 @@ namespace Natives
 		ucell end = params[3];
 		if(begin >= ptr->size()) amx_LogicError(errors::out_of_range, "begin");
 		if(end >= ptr->size() || end < begin) amx_LogicError(errors::out_of_range, "end");
+		dyn_object buffer;
 		for(ucell i = begin; i <= end; i++)
 		{
-			(*ptr)[i].release();
+			ptr->get(i, buffer).release();
 		}
-		ptr->erase(ptr->begin() + params[2], ptr->begin() + params[3]);
+		ptr->erase(params[2], params[3]);
 		return 1;
 	}
 
@@ -624,6 +793,10 @@ namespace Natives
 		list_t *ptr;
 		if(!list_pool.get_by_id(params[1], ptr)) amx_LogicError(errors::pointer_invalid, "list", params[1]);
 		if(static_cast<ucell>(params[2]) >= ptr->size()) amx_LogicError(errors::out_of_range, "index");
+		if(ptr->is_compact())
+		{
+			return ptr->get_cell_tag()->get_id(amx);
+		}
 		auto &obj = (*ptr)[params[2]];
 		return obj.get_tag(amx);
 	}
@@ -635,8 +808,8 @@ namespace Natives
 		list_t *ptr;
 		if(!list_pool.get_by_id(params[1], ptr)) amx_LogicError(errors::pointer_invalid, "list", params[1]);
 		if(static_cast<ucell>(params[2]) >= ptr->size()) amx_LogicError(errors::out_of_range, "index");
-		auto &obj = (*ptr)[params[2]];
-		return obj.get_size();
+		dyn_object buffer;
+		return ptr->get(params[2], buffer).get_size();
 	}
 
 	// native list_find(List:list, AnyTag:value, index=0, TagTag:tag_id=tagof(value));
@@ -707,9 +880,10 @@ namespace Natives
 			args.push_back(std::cref(key));
 			args.push_back(std::cref(key));
 			expression::exec_info info(amx);
+			dyn_object buffer;
 			for(size_t i = static_cast<size_t>(index); i < ptr->size(); i++)
 			{
-				args[0] = std::cref((*ptr)[i]);
+				args[0] = std::cref(ptr->get(i, buffer));
 				key = dyn_object(i, tags::find_tag(tags::tag_cell));
 				if(expr->execute_bool(args, info))
 				{
@@ -740,9 +914,10 @@ namespace Natives
 			args.push_back(std::cref(key));
 			args.push_back(std::cref(key));
 			expression::exec_info info(amx);
+			dyn_object buffer;
 			while(index >= 0)
 			{
-				args[0] = std::cref((*ptr)[index]);
+				args[0] = std::cref(ptr->get(index, buffer));
 				key = dyn_object(index, tags::find_tag(tags::tag_cell));
 				if(expr->execute_bool(args, info))
 				{
@@ -768,10 +943,25 @@ namespace Natives
 		expression::exec_info info(amx);
 		
 		cell count = 0;
+		if(ptr->is_compact())
+		{
+			erase_compact_if(*ptr, [&](const dyn_object &obj, size_t index)
+			{
+				args[0] = std::cref(obj);
+				key = dyn_object(index, tags::find_tag(tags::tag_cell));
+				if(expr->execute_bool(args, info))
+				{
+					count++;
+					return true;
+				}
+				return false;
+			});
+			return count;
+		}
 		ptr->erase(std::remove_if(ptr->begin(), ptr->end(), [&](const dyn_object &obj)
 		{
 			args[0] = std::cref(obj);
-			key = dyn_object(&obj - &*ptr->cbegin(), tags::find_tag(tags::tag_cell));
+			key = dyn_object(&obj - &*ptr->begin(), tags::find_tag(tags::tag_cell));
 			if(expr->execute_bool(args, info))
 			{
 				count++;
@@ -795,10 +985,26 @@ namespace Natives
 		args.push_back(std::cref(key));
 		expression::exec_info info(amx);
 		cell count = 0;
+		if(ptr->is_compact())
+		{
+			// the elements have plain cell tags, so there is nothing to release
+			erase_compact_if(*ptr, [&](const dyn_object &obj, size_t index)
+			{
+				args[0] = std::cref(obj);
+				key = dyn_object(index, tags::find_tag(tags::tag_cell));
+				if(expr->execute_bool(args, info))
+				{
+					count++;
+					return true;
+				}
+				return false;
+			});
+			return count;
+		}
 		ptr->erase(std::remove_if(ptr->begin(), ptr->end(), [&](const dyn_object &obj)
 		{
 			args[0] = std::cref(obj);
-			key = dyn_object(&obj - &*ptr->cbegin(), tags::find_tag(tags::tag_cell));
+			key = dyn_object(&obj - &*ptr->begin(), tags::find_tag(tags::tag_cell));
 			if(expr->execute_bool(args, info))
 			{
 				obj.release();
@@ -847,12 +1053,18 @@ namespace Natives
 		args.push_back(std::cref(key));
 		expression::exec_info info(amx);
 
-		return std::count_if(ptr->begin(), ptr->end(), [&](const dyn_object &obj)
+		cell count = 0;
+		dyn_object buffer;
+		for(size_t i = 0; i < ptr->size(); i++)
 		{
-			args[0] = std::cref(obj);
-			key = dyn_object(&obj - &*ptr->cbegin(), tags::find_tag(tags::tag_cell));
-			return expr->execute_bool(args, info);
-		});
+			args[0] = std::cref(ptr->get(i, buffer));
+			key = dyn_object(i, tags::find_tag(tags::tag_cell));
+			if(expr->execute_bool(args, info))
+			{
+				count++;
+			}
+		}
+		return count;
 	}
 
 	struct cell_sorter
@@ -921,42 +1133,37 @@ namespace Natives
 
 		bool simple = offset == 0 && size == -1;
 
-		if(!reverse)
+		if(ptr->is_compact() && (simple || (offset == 0 && size != 0)))
 		{
-			auto begin = ptr->begin(), end = ptr->end();
-			if(stable)
+			if(ptr->size() > 0)
 			{
-				if(simple)
+				auto &cells = ptr->get_cells();
+				if(!reverse)
 				{
-					std::stable_sort(begin, end);
+					sort_cells(cells.begin(), cells.end(), ptr->get_cell_tag(), stable);
 				}else{
-					std::stable_sort(begin, end, cell_sorter(offset, size));
+					sort_cells(cells.rbegin(), cells.rend(), ptr->get_cell_tag(), stable);
 				}
+			}
+			return 1;
+		}
+
+		bool parallel = sort_workers.size() > 0 && ptr->size() >= sort_parallel_threshold && has_plain_cell_tags(*ptr);
+
+		if(!reverse)
+		{
+			if(simple)
+			{
+				sort_range(ptr->begin(), ptr->end(), std::less<dyn_object>(), stable, parallel);
 			}else{
-				if(simple)
-				{
-					std::sort(begin, end);
-				}else{
-					std::sort(begin, end, cell_sorter(offset, size));
-				}
+				sort_range(ptr->begin(), ptr->end(), cell_sorter(offset, size), stable, parallel);
 			}
 		}else{
-			auto begin = ptr->rbegin(), end = ptr->rend();
-			if(stable)
+			if(simple)
 			{
-				if(simple)
-				{
-					std::stable_sort(begin, end);
-				}else{
-					std::stable_sort(begin, end, cell_sorter(offset, size));
-				}
+				sort_range(ptr->rbegin(), ptr->rend(), std::less<dyn_object>(), stable, parallel);
 			}else{
-				if(simple)
-				{
-					std::sort(begin, end);
-				}else{
-					std::sort(begin, end, cell_sorter(offset, size));
-				}
+				sort_range(ptr->rbegin(), ptr->rend(), cell_sorter(offset, size), stable, parallel);
 			}
 		}
 		return 1;
@@ -1000,6 +1207,22 @@ namespace Natives
 
 		expression::exec_info info(amx);
 		expr_sorter sorter(expr, info);
+		if(ptr->is_compact())
+		{
+			auto &cells = ptr->get_cells();
+			tag_ptr tag = ptr->get_cell_tag();
+			auto comp = [&](cell a, cell b)
+			{
+				return sorter(dyn_object(a, tag), dyn_object(b, tag));
+			};
+			if(!reverse)
+			{
+				sort_range(cells.begin(), cells.end(), comp, stable, false);
+			}else{
+				sort_range(cells.rbegin(), cells.rend(), comp, stable, false);
+			}
+			return 1;
+		}
 		if(!reverse)
 		{
 			auto begin = ptr->begin(), end = ptr->end();
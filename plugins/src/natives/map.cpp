@@ -695,25 +695,25 @@ namespace Natives
 	// native bool:map_str_add(Map:map, const key[], AnyTag:value, TagTag:value_tag_id=tagof(value));
 	AMX_DEFINE_NATIVE_TAG(map_str_add, 4, bool)
 	{
-		return key_at<2>::value_at<3, 4>::map_add<dyn_func_str, dyn_func>(amx, params);
+		return key_at<2>::value_at<3, 4>::map_add<dyn_func_str_key, dyn_func>(amx, params);
 	}
 
 	// native bool:map_str_add_arr(Map:map, const key[], const AnyTag:value[], value_size=sizeof(value), TagTag:value_tag_id=tagof(value));
 	AMX_DEFINE_NATIVE_TAG(map_str_add_arr, 5, bool)
 	{
-		return key_at<2>::value_at<3, 4, 5>::map_add<dyn_func_str, dyn_func_arr>(amx, params);
+		return key_at<2>::value_at<3, 4, 5>::map_add<dyn_func_str_key, dyn_func_arr>(amx, params);
 	}
 
 	// native bool:map_str_add_str(Map:map, const key[], const value[]);
 	AMX_DEFINE_NATIVE_TAG(map_str_add_str, 3, bool)
 	{
-		return key_at<2>::value_at<3>::map_add<dyn_func_str, dyn_func_str>(amx, params);
+		return key_at<2>::value_at<3>::map_add<dyn_func_str_key, dyn_func_str>(amx, params);
 	}
 
 	// native bool:map_str_add_var(Map:map, const key[], VariantTag:value);
 	AMX_DEFINE_NATIVE_TAG(map_str_add_var, 3, bool)
 	{
-		return key_at<2>::value_at<3>::map_add<dyn_func_str, dyn_func_var>(amx, params);
+		return key_at<2>::value_at<3>::map_add<dyn_func_str_key, dyn_func_var>(amx, params);
 	}
 
 	// native bool:map_var_add(Map:map, VariantTag:key, AnyTag:value, TagTag:value_tag_id=tagof(value));
@@ -1098,7 +1098,7 @@ namespace Natives
 	// native bool:map_str_remove(Map:map, const key[]);
 	AMX_DEFINE_NATIVE_TAG(map_str_remove, 2, bool)
 	{
-		return key_at<2>::map_remove<dyn_func_str>(amx, params);
+		return key_at<2>::map_remove<dyn_func_str_key>(amx, params);
 	}
 
 	// native bool:map_str_remove(Map:map, VariantTag:key);
@@ -1122,7 +1122,7 @@ namespace Natives
 	// native bool:map_str_remove_deep(Map:map, const key[]);
 	AMX_DEFINE_NATIVE_TAG(map_str_remove_deep, 2, bool)
 	{
-		return key_at<2>::map_remove_deep<dyn_func_str>(amx, params);
+		return key_at<2>::map_remove_deep<dyn_func_str_key>(amx, params);
 	}
 
 	// native bool:map_str_remove_deep(Map:map, VariantTag:key);
@@ -1216,7 +1216,7 @@ namespace Natives
 	// native bool:map_has_str_key(Map:map, const key[]);
 	AMX_DEFINE_NATIVE_TAG(map_has_str_key, 2, bool)
 	{
-		return key_at<2>::map_has_key<dyn_func_str>(amx, params);
+		return key_at<2>::map_has_key<dyn_func_str_key>(amx, params);
 	}
 
 	// native bool:map_has_var_key(Map:map, VariantTag:key);
@@ -1324,49 +1324,49 @@ namespace Natives
 	// native map_str_get(Map:map, const key[], offset=0);
 	AMX_DEFINE_NATIVE(map_str_get, 3)
 	{
-		return key_at<2>::value_at<3>::map_get<dyn_func_str, dyn_func>(amx, params);
+		return key_at<2>::value_at<3>::map_get<dyn_func_str_key, dyn_func>(amx, params);
 	}
 
 	// native map_str_get_arr(Map:map, const key[], AnyTag:value[], value_size=sizeof(value));
 	AMX_DEFINE_NATIVE_TAG(map_str_get_arr, 4, cell)
 	{
-		return key_at<2>::value_at<3, 4>::map_get<dyn_func_str, dyn_func_arr>(amx, params);
+		return key_at<2>::value_at<3, 4>::map_get<dyn_func_str_key, dyn_func_arr>(amx, params);
 	}
 
 	// native String:map_str_get_str_s(Map:map, const key[]);
 	AMX_DEFINE_NATIVE_TAG(map_str_get_str_s, 2, string)
 	{
-		return key_at<2>::value_at<>::map_get<dyn_func_str, dyn_func_str_s>(amx, params);
+		return key_at<2>::value_at<>::map_get<dyn_func_str_key, dyn_func_str_s>(amx, params);
 	}
 
 	// native Variant:map_str_get_var(Map:map, const key[]);
 	AMX_DEFINE_NATIVE_TAG(map_str_get_var, 2, variant)
 	{
-		return key_at<2>::value_at<>::map_get<dyn_func_str, dyn_func_var>(amx, params);
+		return key_at<2>::value_at<>::map_get<dyn_func_str_key, dyn_func_var>(amx, params);
 	}
 
 	// native bool:map_str_get_safe(Map:map, const key[], &AnyTag:value, offset=0, TagTag:value_tag_id=tagof(value));
 	AMX_DEFINE_NATIVE_TAG(map_str_get_safe, 5, bool)
 	{
-		return key_at<2>::value_at<3, 4, 5>::map_get<dyn_func_str, dyn_func>(amx, params);
+		return key_at<2>::value_at<3, 4, 5>::map_get<dyn_func_str_key, dyn_func>(amx, params);
 	}
 
 	// native map_str_get_arr_safe(Map:map, const key[], AnyTag:value[], value_size=sizeof(value), TagTag:value_tag_id=tagof(value));
 	AMX_DEFINE_NATIVE_TAG(map_str_get_arr_safe, 5, cell)
 	{
-		return key_at<2>::value_at<3, 4, 5>::map_get<dyn_func_str, dyn_func_arr>(amx, params);
+		return key_at<2>::value_at<3, 4, 5>::map_get<dyn_func_str_key, dyn_func_arr>(amx, params);
 	}
 
 	// native map_str_get_str_safe(Map:map, const key[], value[], value_size=sizeof(value));
 	AMX_DEFINE_NATIVE_TAG(map_str_get_str_safe, 4, cell)
 	{
-		return key_at<2>::value_at<3, 4>::map_get<dyn_func_str, dyn_func_str>(amx, params);
+		return key_at<2>::value_at<3, 4>::map_get<dyn_func_str_key, dyn_func_str>(amx, params);
 	}
 
 	// native String:map_str_get_str_safe_s(Map:map, const key[]);
 	AMX_DEFINE_NATIVE_TAG(map_str_get_str_safe_s, 2, string)
 	{
-		return key_at<2>::value_at<0>::map_get<dyn_func_str, dyn_func_str_s>(amx, params);
+		return key_at<2>::value_at<0>::map_get<dyn_func_str_key, dyn_func_str_s>(amx, params);
 	}
 
 	// native map_var_get(Map:map, VariantTag:key, offset=0);
@@ -1492,37 +1492,37 @@ namespace Natives
 	// native map_str_set(Map:map, const key[], AnyTag:value, TagTag:value_tag_id=tagof(value));
 	AMX_DEFINE_NATIVE_TAG(map_str_set, 4, cell)
 	{
-		return key_at<2>::value_at<3, 4>::map_set<dyn_func_str, dyn_func>(amx, params);
+		return key_at<2>::value_at<3, 4>::map_set<dyn_func_str_key, dyn_func>(amx, params);
 	}
 
 	// native map_str_set_arr(Map:map, const key[], const AnyTag:value[], value_size=sizeof(value), TagTag:value_tag_id=tagof(value));
 	AMX_DEFINE_NATIVE_TAG(map_str_set_arr, 5, cell)
 	{
-		return key_at<2>::value_at<3, 4, 5>::map_set<dyn_func_str, dyn_func_arr>(amx, params);
+		return key_at<2>::value_at<3, 4, 5>::map_set<dyn_func_str_key, dyn_func_arr>(amx, params);
 	}
 
 	// native map_str_set_str(Map:map, const key[], const value[]);
 	AMX_DEFINE_NATIVE_TAG(map_str_set_str, 3, cell)
 	{
-		return key_at<2>::value_at<3>::map_set<dyn_func_str, dyn_func_str>(amx, params);
+		return key_at<2>::value_at<3>::map_set<dyn_func_str_key, dyn_func_str>(amx, params);
 	}
 
 	// native map_str_set_var(Map:map, const key[], VariantTag:value);
 	AMX_DEFINE_NATIVE_TAG(map_str_set_var, 3, cell)
 	{
-		return key_at<2>::value_at<3>::map_set<dyn_func_str, dyn_func_var>(amx, params);
+		return key_at<2>::value_at<3>::map_set<dyn_func_str_key, dyn_func_var>(amx, params);
 	}
 
 	// native map_str_set_cell(Map:map, const key[], offset, AnyTag:value);
 	AMX_DEFINE_NATIVE_TAG(map_str_set_cell, 4, cell)
 	{
-		return key_at<2>::map_set_cell<dyn_func_str>(amx, params);
+		return key_at<2>::map_set_cell<dyn_func_str_key>(amx, params);
 	}
 
 	// native bool:map_str_set_cell_safe(Map:map, const key[], offset, AnyTag:value, TagTag:value_tag_id=tagof(value));
 	AMX_DEFINE_NATIVE_TAG(map_str_set_cell_safe, 5, bool)
 	{
-		return key_at<2>::map_set_cell<dyn_func_str, 5>(amx, params);
+		return key_at<2>::map_set_cell<dyn_func_str_key, 5>(amx, params);
 	}
 
 	// native map_var_set(Map:map, VariantTag:key, AnyTag:value, TagTag:value_tag_id=tagof(value));
@@ -1702,13 +1702,13 @@ namespace Natives
 	// native map_str_tagof(Map:map, const key[]);
 	AMX_DEFINE_NATIVE_TAG(map_str_tagof, 2, cell)
 	{
-		return key_at<2>::map_tagof<dyn_func_str>(amx, params);
+		return key_at<2>::map_tagof<dyn_func_str_key>(amx, params);
 	}
 
 	// native map_str_sizeof(Map:map, const key[]);
 	AMX_DEFINE_NATIVE_TAG(map_str_sizeof, 2, cell)
 	{
-		return key_at<2>::map_sizeof<dyn_func_str>(amx, params);
+		return key_at<2>::map_sizeof<dyn_func_str_key>(amx, params);
 	}
 
 	// native map_var_tagof(Map:map, VariantTag:key);
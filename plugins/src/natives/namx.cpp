@@ -1,6 +1,7 @@
 #include "natives.h"
 #include "amxinfo.h"
 #include "context.h"
+#include "exec.h"
 #include "errors.h"
 #include "modules/amxutils.h"
 #include "modules/strings.h"
@@ -581,6 +582,28 @@ namespace Natives
 		return SleepReturnForkEnd;
 	}
 
+	// native amx_fork_pool(size);
+	AMX_DEFINE_NATIVE_TAG(amx_fork_pool, 1, cell)
+	{
+		if(params[1] < 0)
+		{
+			amx_LogicError(errors::out_of_range, "size");
+		}
+		cell old = static_cast<cell>(fork_pool_size);
+		fork_pool_size = static_cast<size_t>(params[1]);
+		return old;
+	}
+
+	// native amx_fork_stats(&created=0, &reused=0);
+	AMX_DEFINE_NATIVE_TAG(amx_fork_stats, 0, cell)
+	{
+		size_t created, reused;
+		size_t idle = fork_pool_stats(created, reused);
+		*optparamref(1, 0) = static_cast<cell>(created);
+		*optparamref(2, 0) = static_cast<cell>(reused);
+		return static_cast<cell>(idle);
+	}
+
 	// native amx_error(amx_err:code, result=0);
 	AMX_DEFINE_NATIVE_TAG(amx_error, 1, cell)
 	{
@@ -718,6 +741,8 @@ static AMX_NATIVE_INFO native_list[] =
 	AMX_DECLARE_NATIVE(amx_fork),
 	AMX_DECLARE_NATIVE(amx_commit),
 	AMX_DECLARE_NATIVE(amx_fork_end),
+	AMX_DECLARE_NATIVE(amx_fork_pool),
+	AMX_DECLARE_NATIVE(amx_fork_stats),
 	AMX_DECLARE_NATIVE(amx_error),
 	AMX_DECLARE_NATIVE(amx_parallel_begin),
 	AMX_DECLARE_NATIVE(amx_parallel_end),
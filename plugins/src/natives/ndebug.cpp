@@ -1653,9 +1653,10 @@ namespace Natives
 
 		cell num = list->size() * sizeof(cell);
 		amx->stk -= num + 2 * sizeof(cell);
+		dyn_object buffer;
 		for(cell i = list->size() - 1; i >= 0; i--)
 		{
-			cell val = (*list)[i].store(amx);
+			cell val = list->get(i, buffer).store(amx);
 			*--stk = val;
 		}
 		*--stk = num;
@@ -1793,9 +1794,10 @@ namespace Natives
 
 		cell num = list->size() * sizeof(cell);
 		amx->stk -= num + 2 * sizeof(cell);
+		dyn_object buffer;
 		for(cell i = list->size() - 1; i >= 0; i--)
 		{
-			cell val = (*list)[i].store(amx);
+			cell val = list->get(i, buffer).store(amx);
 			*--stk = val;
 		}
 		*--stk = num;
@@ -1,6 +1,7 @@
 #include "natives.h"
 #include "context.h"
 #include "modules/strings.h"
+#include "modules/threads.h"
 #include <thread>
 #include <sstream>
 
@@ -53,6 +54,33 @@ namespace Natives
 		return strings::create(buf.str());
 	}
 
+	// native thread_workers(count);
+	AMX_DEFINE_NATIVE_TAG(thread_workers, 1, cell)
+	{
+		if(params[1] < 0)
+		{
+			amx_LogicError(errors::out_of_range, "count");
+		}
+		if(!is_main_thread)
+		{
+			// the workers are owned by the main thread
+			amx_LogicError(errors::operation_not_supported, "thread");
+		}
+		return static_cast<cell>(Threads::SetMaxWorkers(static_cast<size_t>(params[1])));
+	}
+
+	// native thread_sync_stats(depths[], waits[], size=sizeof(depths));
+	AMX_DEFINE_NATIVE_TAG(thread_sync_stats, 3, cell)
+	{
+		if(params[3] < 0)
+		{
+			amx_LogicError(errors::out_of_range, "size");
+		}
+		cell *depths = amx_GetAddrSafe(amx, params[1]);
+		cell *waits = amx_GetAddrSafe(amx, params[2]);
+		return static_cast<cell>(Threads::GetSyncStats(depths, waits, static_cast<size_t>(params[3])));
+	}
+
 	// native bool:thread_fix();
 	AMX_DEFINE_NATIVE_TAG(thread_fix, 0, bool)
 	{
@@ -74,6 +102,8 @@ static AMX_NATIVE_INFO native_list[] =
 	AMX_DECLARE_NATIVE(thread_id),
 	AMX_DECLARE_NATIVE(thread_id_s),
 	AMX_DECLARE_NATIVE(thread_fix),
+	AMX_DECLARE_NATIVE(thread_workers),
+	AMX_DECLARE_NATIVE(thread_sync_stats),
 };
 
 int RegisterThreadNatives(AMX *amx)
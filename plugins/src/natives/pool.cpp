@@ -7,6 +7,33 @@
 #include <vector>
 #include <algorithm>
 
+// matches elements equal to a value, comparing cells directly for elements with the same bitwise tag
+class value_matcher
+{
+	const dyn_object &value;
+	tag_ptr cell_tag = nullptr;
+	cell key = 0;
+
+public:
+	value_matcher(const dyn_object &value) : value(value)
+	{
+		if(value.is_cell() && has_bitwise_eq(value.get_tag()))
+		{
+			cell_tag = value.get_tag();
+			key = *value.begin();
+		}
+	}
+
+	bool operator()(const dyn_object &obj) const
+	{
+		if(cell_tag != nullptr && obj.is_cell() && obj.get_tag() == cell_tag)
+		{
+			return *obj.begin() == key;
+		}
+		return obj == value;
+	}
+};
+
 template <size_t... Indices>
 class value_at
 {
@@ -55,9 +82,10 @@ public:
 		pool_t *ptr;
 		if(!pool_pool.get_by_id(params[1], ptr)) amx_LogicError(errors::pointer_invalid, "pool", params[1]);
 		auto find = Factory(amx, params[Indices]...);
+		value_matcher matcher(find);
 		for(auto it = ptr->begin(); it != ptr->end(); ++it)
 		{
-			if(*it == find)
+			if(matcher(*it))
 			{
 				return ptr->index_of(it);
 			}
@@ -71,7 +99,8 @@ public:
 	{
 		pool_t *ptr;
 		if(!pool_pool.get_by_id(params[1], ptr)) amx_LogicError(errors::pointer_invalid, "pool", params[1]);
-		return std::count(ptr->begin(), ptr->end(), Factory(amx, params[Indices]...));
+		auto find = Factory(amx, params[Indices]...);
+		return std::count_if(ptr->begin(), ptr->end(), value_matcher(find));
 	}
 };
 
@@ -105,7 +134,7 @@ namespace Natives
 			amx_LogicError(errors::out_of_range, "size");
 		}
 		bool ordered = optparam(2, 0);
-		auto &pool = pool_pool.emplace(ordered);
+		auto pool = pool_pool.emplace(ordered);
 		pool->resize(size);
 		return pool_pool.get_id(pool);
 	}
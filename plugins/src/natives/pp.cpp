@@ -5,15 +5,19 @@
 #include "context.h"
 #include "modules/tasks.h"
 #include "modules/strings.h"
+#include "modules/regex.h"
 #include "modules/format.h"
 #include "modules/variants.h"
 #include "modules/guards.h"
 #include "modules/containers.h"
 #include "modules/amxhook.h"
 #include "modules/expressions.h"
+#include "objects/reset.h"
 #include "utils/systools.h"
 
 #include <cstring>
+#include <thread>
+#include <system_error>
 #ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
@@ -430,6 +434,89 @@ namespace Natives
 		return stackspace();
 	}
 
+	// native timer_clock:pp_timer_clock(timer_clock:clock);
+	AMX_DEFINE_NATIVE_TAG(pp_timer_clock, 1, cell)
+	{
+		cell clock = params[1];
+		if(clock < static_cast<cell>(tasks::timer_clock::exact) || clock > static_cast<cell>(tasks::timer_clock::coarse))
+		{
+			amx_LogicError(errors::out_of_range, "clock");
+		}
+		return static_cast<cell>(tasks::set_timer_clock(static_cast<tasks::timer_clock>(clock)));
+	}
+
+	// native pp_sort_threads(threads, min_size=-1);
+	AMX_DEFINE_NATIVE_TAG(pp_sort_threads, 1, cell)
+	{
+		cell threads = params[1];
+		// more threads than the machine can run at once would only compete for the same cores
+		unsigned int max_threads = std::thread::hardware_concurrency();
+		if(max_threads == 0)
+		{
+			max_threads = 64;
+		}
+		if(threads < 0 || static_cast<ucell>(threads) > max_threads)
+		{
+			amx_LogicError(errors::out_of_range, "threads");
+		}
+		cell min_size = optparam(2, -1);
+		if(min_size < -1)
+		{
+			amx_LogicError(errors::out_of_range, "min_size");
+		}
+		cell old = static_cast<cell>(sort_workers.size());
+		try{
+			sort_workers.resize(static_cast<size_t>(threads));
+		}catch(const std::system_error &)
+		{
+			// the threads that were started would leave the pool in a state that was not asked for
+			sort_workers.resize(0);
+			amx_LogicError(errors::out_of_range, "threads");
+		}
+		if(min_size != -1)
+		{
+			sort_parallel_threshold = static_cast<size_t>(min_size);
+		}
+		return old;
+	}
+
+	// native pp_snapshot_stats(&hits=0, &misses=0);
+	AMX_DEFINE_NATIVE_TAG(pp_snapshot_stats, 0, cell)
+	{
+		size_t hits, misses;
+		size_t cached = amx::snapshot_stats(hits, misses);
+		*optparamref(1, 0) = static_cast<cell>(hits);
+		*optparamref(2, 0) = static_cast<cell>(misses);
+		return static_cast<cell>(cached);
+	}
+
+	// native pp_regex_cache_stats(&hits=0, &misses=0, &count=0);
+	AMX_DEFINE_NATIVE_TAG(pp_regex_cache_stats, 0, cell)
+	{
+		size_t hits, misses, count;
+		size_t size = strings::regex_cache_stats(hits, misses, count);
+		*optparamref(1, 0) = static_cast<cell>(hits);
+		*optparamref(2, 0) = static_cast<cell>(misses);
+		*optparamref(3, 0) = static_cast<cell>(count);
+		return static_cast<cell>(size);
+	}
+
+	// native pp_regex_cache_capacity(capacity=-1);
+	AMX_DEFINE_NATIVE_TAG(pp_regex_cache_capacity, 0, cell)
+	{
+		cell capacity = optparam(1, -1);
+		if(capacity < -1)
+		{
+			amx_LogicError(errors::out_of_range, "capacity");
+		}
+		cell old = static_cast<cell>(strings::get_regex_cache_capacity());
+		if(capacity != -1)
+		{
+			strings::set_regex_cache_capacity(static_cast<size_t>(capacity));
+		}
+		return old;
+	}
+
 	// native pp__reserved1();
 	AMX_DEFINE_NATIVE(pp__reserved1, 0)
 	{
@@ -571,6 +658,11 @@ static AMX_NATIVE_INFO native_list[] =
 	AMX_DECLARE_NATIVE(pp_format_env_push),
 	AMX_DECLARE_NATIVE(pp_format_env_pop),
 	AMX_DECLARE_NATIVE(pp_stackspace),
+	AMX_DECLARE_NATIVE(pp_timer_clock),
+	AMX_DECLARE_NATIVE(pp_sort_threads),
+	AMX_DECLARE_NATIVE(pp_snapshot_stats),
+	AMX_DECLARE_NATIVE(pp_regex_cache_stats),
+	AMX_DECLARE_NATIVE(pp_regex_cache_capacity),
 
 	//Reserved for private use
 	AMX_DECLARE_NATIVE(pp__reserved1),
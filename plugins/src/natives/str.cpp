@@ -4,6 +4,7 @@
 #include "modules/strings.h"
 #include "modules/format.h"
 #include "modules/regex.h"
+#include "modules/word_set.h"
 #include "modules/variants.h"
 #include "modules/expressions.h"
 #include "objects/dyn_object.h"
@@ -296,16 +297,14 @@ namespace Natives
 		cell operator()(Iter delim_begin, Iter delim_end, AMX *amx, list_t *list) const
 		{
 			auto &str = strings::pool.add();
-			bool first = true;
-			for(auto &obj : *list)
+			dyn_object buffer;
+			for(size_t i = 0; i < list->size(); i++)
 			{
-				if(first)
+				if(i > 0)
 				{
-					first = false;
-				}else{
 					str->append(delim_begin, delim_end);
 				}
-				str->append(obj.to_string());
+				str->append(list->get(i, buffer).to_string());
 			}
 
 			return strings::pool.get_id(str);
@@ -670,6 +669,67 @@ namespace Natives
 		return params[1];
 	}
 
+	// native Format:str_format_compile(const format[]);
+	AMX_DEFINE_NATIVE_TAG(str_format_compile, 1, cell)
+	{
+		cell *format = amx_GetAddrSafe(amx, params[1]);
+		return strings::format_compile(amx, format);
+	}
+
+	// native Format:str_format_compile_s(ConstStringTag:format);
+	AMX_DEFINE_NATIVE_TAG(str_format_compile_s, 1, cell)
+	{
+		cell_string *strformat;
+		if(!strings::pool.get_by_id(params[1], strformat) && strformat != nullptr) amx_LogicError(errors::pointer_invalid, "string", params[1]);
+		if(strformat != nullptr)
+		{
+			return strings::format_compile(amx, *strformat);
+		}
+		return strings::format_compile(amx, cell_string());
+	}
+
+	// native bool:str_format_delete(Format:format);
+	AMX_DEFINE_NATIVE_TAG(str_format_delete, 1, bool)
+	{
+		return strings::format_delete(amx, params[1]);
+	}
+
+	// native String:str_format_run(Format:format, AnyTag:...);
+	AMX_DEFINE_NATIVE_TAG(str_format_run, 1, string)
+	{
+		auto format = strings::format_find(amx, params[1]);
+		if(format == nullptr) amx_LogicError(errors::pointer_invalid, "format", params[1]);
+
+		cell_string target;
+		strings::format(amx, target, *format, params[0] / sizeof(cell) - 1, params + 2);
+		return strings::pool.get_id(strings::pool.add(std::move(target)));
+	}
+
+	// native String:str_set_format_run(StringTag:target, Format:format, AnyTag:...);
+	AMX_DEFINE_NATIVE_TAG(str_set_format_run, 2, string)
+	{
+		cell_string *str;
+		if(!strings::pool.get_by_id(params[1], str)) amx_LogicError(errors::pointer_invalid, "string", params[1]);
+		auto format = strings::format_find(amx, params[2]);
+		if(format == nullptr) amx_LogicError(errors::pointer_invalid, "format", params[2]);
+		str->clear();
+
+		strings::format(amx, *str, *format, params[0] / sizeof(cell) - 2, params + 3);
+		return params[1];
+	}
+
+	// native String:str_append_format_run(StringTag:target, Format:format, AnyTag:...);
+	AMX_DEFINE_NATIVE_TAG(str_append_format_run, 2, string)
+	{
+		cell_string *str;
+		if(!strings::pool.get_by_id(params[1], str)) amx_LogicError(errors::pointer_invalid, "string", params[1]);
+		auto format = strings::format_find(amx, params[2]);
+		if(format == nullptr) amx_LogicError(errors::pointer_invalid, "format", params[2]);
+
+		strings::format(amx, *str, *format, params[0] / sizeof(cell) - 2, params + 3);
+		return params[1];
+	}
+
 	// native String:str_to_lower(StringTag:str);
 	AMX_DEFINE_NATIVE_TAG(str_to_lower, 1, string)
 	{
@@ -1352,6 +1412,99 @@ namespace Natives
 
 		return params[1];
 	}
+
+	// native WordSet:str_words_new(List:words, bool:ignore_case=false);
+	AMX_DEFINE_NATIVE_TAG(str_words_new, 1, cell)
+	{
+		list_t *list;
+		if(!list_pool.get_by_id(params[1], list)) amx_LogicError(errors::pointer_invalid, "list", params[1]);
+
+		std::vector<cell_string> words;
+		words.reserve(list->size());
+		dyn_object buffer;
+		for(size_t i = 0; i < list->size(); i++)
+		{
+			words.push_back(list->get(i, buffer).to_string());
+		}
+		return strings::word_set_pool.get_id(strings::word_set_pool.emplace(words, !!optparam(2, 0)));
+	}
+
+	// native bool:str_words_valid(WordSet:words);
+	AMX_DEFINE_NATIVE_TAG(str_words_valid, 1, bool)
+	{
+		strings::word_set *words;
+		return strings::word_set_pool.get_by_id(params[1], words);
+	}
+
+	// native str_words_delete(WordSet:words);
+	AMX_DEFINE_NATIVE_TAG(str_words_delete, 1, cell)
+	{
+		strings::word_set *words;
+		if(!strings::word_set_pool.get_by_id(params[1], words)) amx_LogicError(errors::pointer_invalid, "word set", params[1]);
+		return strings::word_set_pool.remove(words);
+	}
+
+	// native str_find_any(ConstStringTag:str, WordSet:words, offset=0, &index=0, &length=0);
+	AMX_DEFINE_NATIVE_TAG(str_find_any, 2, cell)
+	{
+		cell_string *str;
+		if(!strings::pool.get_by_id(params[1], str) && str != nullptr) amx_LogicError(errors::pointer_invalid, "string", params[1]);
+		strings::word_set *words;
+		if(!strings::word_set_pool.get_by_id(params[2], words)) amx_LogicError(errors::pointer_invalid, "word set", params[2]);
+		if(str == nullptr) return -1;
+
+		cell offset = optparam(3, 0);
+		strings::clamp_pos(*str, offset);
+
+		strings::word_set::match match;
+		if(!words->find(str->data(), str->size(), static_cast<size_t>(offset), match))
+		{
+			return -1;
+		}
+		*optparamref(4, 0) = static_cast<cell>(match.index);
+		*optparamref(5, 0) = static_cast<cell>(match.length);
+		return static_cast<cell>(match.pos);
+	}
+
+	// native String:str_replace_words(ConstStringTag:str, WordSet:words, const replacement[], bool:fill=false, &count=0);
+	AMX_DEFINE_NATIVE_TAG(str_replace_words, 3, string)
+	{
+		cell_string *str;
+		if(!strings::pool.get_by_id(params[1], str) && str != nullptr) amx_LogicError(errors::pointer_invalid, "string", params[1]);
+		strings::word_set *words;
+		if(!strings::word_set_pool.get_by_id(params[2], words)) amx_LogicError(errors::pointer_invalid, "word set", params[2]);
+
+		cell_string replacement = strings::convert(amx_GetAddrSafe(amx, params[3]));
+		bool fill = !!optparam(4, 0);
+
+		cell_string target;
+		cell count = 0;
+		if(str != nullptr)
+		{
+			size_t pos = 0;
+			strings::word_set::match match;
+			while(words->find(str->data(), str->size(), pos, match))
+			{
+				target.append(*str, pos, match.pos - pos);
+				if(!fill)
+				{
+					target.append(replacement);
+				}else if(!replacement.empty())
+				{
+					// the replacement is repeated to cover the whole word
+					for(size_t i = 0; i < match.length; i++)
+					{
+						target.push_back(replacement[i % replacement.size()]);
+					}
+				}
+				pos = match.pos + match.length;
+				count++;
+			}
+			target.append(*str, pos, cell_string::npos);
+		}
+		*optparamref(5, 0) = count;
+		return strings::pool.get_id(strings::pool.add(std::move(target)));
+	}
 }
 
 static AMX_NATIVE_INFO native_list[] =
@@ -1408,6 +1561,12 @@ static AMX_NATIVE_INFO native_list[] =
 	AMX_DECLARE_NATIVE(str_set_format_s),
 	AMX_DECLARE_NATIVE(str_append_format),
 	AMX_DECLARE_NATIVE(str_append_format_s),
+	AMX_DECLARE_NATIVE(str_format_compile),
+	AMX_DECLARE_NATIVE(str_format_compile_s),
+	AMX_DECLARE_NATIVE(str_format_delete),
+	AMX_DECLARE_NATIVE(str_format_run),
+	AMX_DECLARE_NATIVE(str_set_format_run),
+	AMX_DECLARE_NATIVE(str_append_format_run),
 
 	AMX_DECLARE_NATIVE(str_match),
 	AMX_DECLARE_NATIVE(str_match_s),
@@ -1429,6 +1588,12 @@ static AMX_NATIVE_INFO native_list[] =
 	AMX_DECLARE_NATIVE(str_set_replace_func_s),
 	AMX_DECLARE_NATIVE(str_set_replace_expr),
 	AMX_DECLARE_NATIVE(str_set_replace_expr_s),
+
+	AMX_DECLARE_NATIVE(str_words_new),
+	AMX_DECLARE_NATIVE(str_words_valid),
+	AMX_DECLARE_NATIVE(str_words_delete),
+	AMX_DECLARE_NATIVE(str_find_any),
+	AMX_DECLARE_NATIVE(str_replace_words),
 };
 
 int RegisterStringsNatives(AMX *amx)
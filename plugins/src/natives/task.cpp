@@ -549,6 +549,13 @@ namespace Natives
 		return 0;
 	}
 
+	// native task_captured_bytes();
+	AMX_DEFINE_NATIVE_TAG(task_captured_bytes, 0, cell)
+	{
+		amx::object owner;
+		return static_cast<cell>(tasks::get_extra(amx, owner).captured_size);
+	}
+
 	// native task_continue_with(Task:task, const handler[], const additional_format[]="", AnyTag:...);
 	AMX_DEFINE_NATIVE_TAG(task_continue_with, 0, cell)
 	{
@@ -768,6 +775,7 @@ static AMX_NATIVE_INFO native_list[] =
 	AMX_DECLARE_NATIVE(task_set_error_ms),
 	AMX_DECLARE_NATIVE(task_set_error_ticks),
 	AMX_DECLARE_NATIVE(task_config),
+	AMX_DECLARE_NATIVE(task_captured_bytes),
 	AMX_DECLARE_NATIVE(task_continue_with),
 	AMX_DECLARE_NATIVE(task_continue_with_bound),
 	AMX_DECLARE_NATIVE(task_detach),
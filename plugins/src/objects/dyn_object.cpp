@@ -9,13 +9,111 @@
 #include <cstring>
 #include <type_traits>
 #include <algorithm>
+#include <unordered_map>
 #include <functional>
+#include <atomic>
+#include <mutex>
 
 bool memequal(void const* ptr1, void const* ptr2, size_t size)
 {
 	return !std::memcmp(ptr1, ptr2, size);
 }
 
+// hands out blocks of a fixed number of cells, carved from larger chunks;
+// freed blocks are linked through their first bytes and reused
+class cell_block_pool
+{
+	static constexpr size_t chunk_size = 4096;
+
+	const size_t block_cells;
+	std::mutex mutex;
+	void *free_list = nullptr;
+
+public:
+	cell_block_pool(size_t block_cells) : block_cells(block_cells)
+	{
+
+	}
+
+	cell *allocate()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if(free_list == nullptr)
+		{
+			size_t count = chunk_size / (block_cells * sizeof(cell));
+			cell *chunk = new cell[count * block_cells];
+			for(size_t i = count; i-- > 0; )
+			{
+				push(chunk + i * block_cells);
+			}
+		}
+		void *block = free_list;
+		std::memcpy(&free_list, block, sizeof(void*));
+		return static_cast<cell*>(block);
+	}
+
+	void deallocate(cell *block) noexcept
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		push(block);
+	}
+
+private:
+	void push(cell *block) noexcept
+	{
+		std::memcpy(block, &free_list, sizeof(void*));
+		free_list = block;
+	}
+};
+
+// arrays of up to 2, 6 and 14 cells, or strings of up to 1, 5 and 13 characters
+static constexpr cell small_block_cells[] = {4, 8, 16};
+
+static cell_block_pool *find_block_pool(cell size) noexcept
+{
+	// never destroyed, since objects in static storage may still hold pooled blocks
+	static cell_block_pool *pools[] = {
+		new cell_block_pool(small_block_cells[0]),
+		new cell_block_pool(small_block_cells[1]),
+		new cell_block_pool(small_block_cells[2])
+	};
+	for(size_t i = 0; i < sizeof(pools) / sizeof(*pools); i++)
+	{
+		if(size <= small_block_cells[i])
+		{
+			return pools[i];
+		}
+	}
+	return nullptr;
+}
+
+// data[0] always holds the number of the remaining cells, so the block size is known when freeing
+static void free_cells(cell *data) noexcept
+{
+	if(auto pool = find_block_pool(data[0] + 1))
+	{
+		pool->deallocate(data);
+	}else{
+		delete[] data;
+	}
+}
+
+cell *dyn_object::allocate(cell size)
+{
+	if(auto pool = find_block_pool(size))
+	{
+		array_data = pool->allocate();
+	}else{
+		array_data = new cell[size];
+	}
+	return array_data;
+}
+
+void dyn_object::deallocate() noexcept
+{
+	free_cells(array_data);
+}
+
 dyn_object::dyn_object(AMX *amx, const cell *arr, cell size, cell tag_id) : rank(1), tag(tags::find_tag(amx, tag_id))
 {
 	if(size < 0)
@@ -24,11 +122,12 @@ dyn_object::dyn_object(AMX *amx, const cell *arr, cell size, cell tag_id) : rank
 	}
 	if(arr != nullptr)
 	{
-		array_data = new cell[size + 2];
+		allocate(size + 2);
 		std::memcpy(array_data + 1, arr, size * sizeof(cell));
 		array_data[size + 1] = 0;
 	}else{
-		array_data = new cell[size + 2]();
+		allocate(size + 2);
+		std::fill_n(array_data, size + 2, 0);
 	}
 	array_data[0] = size + 1;
 	init_op();
@@ -100,13 +199,14 @@ dyn_object::dyn_object(AMX *amx, const cell *arr, cell size, cell size2, tag_ptr
 			find_array_end(amx, last);
 		}
 		cell length = last - arr;
-		array_data = new cell[length + 2];
+		allocate(length + 2);
 		std::memcpy(array_data + 1, arr, length * sizeof(cell));
 		array_data[length + 1] = 0;
 		array_data[0] = length + 1;
 	}else{
 		cell length = size + size * size2;
-		array_data = new cell[length + 2]();
+		allocate(length + 2);
+		std::fill_n(array_data, length + 2, 0);
 		for(cell i = 0; i < size; i++)
 		{
 			array_data[1 + i] = (size + i * size2 - i) * sizeof(cell);
@@ -149,13 +249,14 @@ dyn_object::dyn_object(AMX *amx, const cell *arr, cell size, cell size2, cell si
 			find_array_end(amx, last);
 		}
 		cell length = last - arr;
-		array_data = new cell[length + 2];
+		allocate(length + 2);
 		std::memcpy(array_data + 1, arr, length * sizeof(cell));
 		array_data[length + 1] = 0;
 		array_data[0] = length + 1;
 	}else{
 		cell length = size + size * size2 + size * size2 * size3;
-		array_data = new cell[length + 2]();
+		allocate(length + 2);
+		std::fill_n(array_data, length + 2, 0);
 		for(cell i = 0; i < size; i++)
 		{
 			array_data[1 + i] = (size + i * size2 - i) * sizeof(cell);
@@ -170,29 +271,178 @@ dyn_object::dyn_object(AMX *amx, const cell *arr, cell size, cell size2, cell si
 	init_op();
 }
 
-dyn_object::dyn_object(const cell *str) : rank(1), tag(tags::find_tag(tags::tag_char))
+cell dyn_object::string_size(const cell *str)
 {
 	if(str == nullptr || !str[0])
 	{
-		array_data = new cell[3]{2, 0, 0};
-		return;
+		return 0;
 	}
 	int len;
 	amx_StrLen(str, &len);
-	size_t size;
 	if(str[0] & 0xFF000000)
 	{
-		size = 1 + ((len - 1) / sizeof(cell));
-	}else{
-		size = len;
+		return 1 + ((len - 1) / sizeof(cell));
 	}
-	array_data = new cell[size + 3];
+	return len;
+}
+
+dyn_object::dyn_object(const cell *str) : rank(1), tag(tags::find_tag(tags::tag_char))
+{
+	cell size = string_size(str);
+	allocate(size + 3);
 	array_data[0] = size + 2;
-	std::memcpy(array_data + 1, str, size * sizeof(cell));
+	if(size > 0)
+	{
+		std::memcpy(array_data + 1, str, size * sizeof(cell));
+	}
 	array_data[size + 2] = 0;
 	array_data[size + 1] = 0;
 }
 
+template <class T>
+inline void hash_combine(size_t& seed, const T& v)
+{
+	std::hash<T> hasher;
+	seed ^= hasher(v) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+// placed before the data of an interned string
+struct interned_header
+{
+	size_t hash;
+	// the last reference is only released with the table locked, so a string found in the table cannot be freed
+	std::atomic<size_t> refs;
+};
+
+static_assert(sizeof(interned_header) % sizeof(cell) == 0, "interned_header must be composed of whole cells");
+static constexpr cell interned_header_cells = sizeof(interned_header) / sizeof(cell);
+
+// interned strings are shared by all scripts and threads
+struct interned_table
+{
+	std::mutex mutex;
+	std::unordered_multimap<size_t, cell*> map;
+};
+
+static interned_table &interned_strings()
+{
+	// never destroyed, since objects in static storage may still refer to it
+	static interned_table *table = new interned_table();
+	return *table;
+}
+
+static interned_header &get_interned_header(cell *data)
+{
+	return *reinterpret_cast<interned_header*>(data - interned_header_cells);
+}
+
+dyn_object dyn_object::intern(const cell *str)
+{
+	cell size = string_size(str);
+	tag_ptr tag = tags::find_tag(tags::tag_char);
+
+	// same as get_hash for the equivalent object
+	const auto &ops = tag->get_ops();
+	size_t hash = 0;
+	for(cell i = 0; i < size; i++)
+	{
+		hash_combine(hash, ops.hash(tag, str[i]));
+	}
+	hash_combine(hash, ops.hash(tag, 0));
+	hash_combine(hash, tag->find_top_base());
+
+	dyn_object obj;
+	obj.tag = tag;
+	obj.interned = true;
+
+	auto &table = interned_strings();
+	std::lock_guard<std::mutex> lock(table.mutex);
+	auto range = table.map.equal_range(hash);
+	for(auto it = range.first; it != range.second; ++it)
+	{
+		cell *data = it->second;
+		if(data[0] == size + 2 && (size == 0 || memequal(data + 1, str, size * sizeof(cell))))
+		{
+			get_interned_header(data).refs.fetch_add(1, std::memory_order_relaxed);
+			obj.array_data = data;
+			return obj;
+		}
+	}
+
+	cell *block = new cell[interned_header_cells + size + 3];
+	cell *data = block + interned_header_cells;
+	auto &header = *new (block) interned_header();
+	header.hash = hash;
+	header.refs.store(1, std::memory_order_relaxed);
+	data[0] = size + 2;
+	if(size > 0)
+	{
+		std::memcpy(data + 1, str, size * sizeof(cell));
+	}
+	data[size + 2] = 0;
+	data[size + 1] = 0;
+	table.map.emplace(hash, data);
+	obj.array_data = data;
+	return obj;
+}
+
+static void release_interned_data(cell *data) noexcept
+{
+	auto &header = get_interned_header(data);
+	size_t refs = header.refs.load(std::memory_order_relaxed);
+	while(refs > 1)
+	{
+		if(header.refs.compare_exchange_weak(refs, refs - 1, std::memory_order_release, std::memory_order_relaxed))
+		{
+			return;
+		}
+	}
+
+	auto &table = interned_strings();
+	std::lock_guard<std::mutex> lock(table.mutex);
+	if(header.refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+	{
+		auto range = table.map.equal_range(header.hash);
+		for(auto it = range.first; it != range.second; ++it)
+		{
+			if(it->second == data)
+			{
+				table.map.erase(it);
+				break;
+			}
+		}
+		header.~interned_header();
+		delete[] (data - interned_header_cells);
+	}
+}
+
+void dyn_object::share(const dyn_object &obj) noexcept
+{
+	array_data = obj.array_data;
+	interned = true;
+	get_interned_header(array_data).refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void dyn_object::unshare()
+{
+	if(interned)
+	{
+		cell *shared = array_data;
+		cell size = shared[0];
+		interned = false;
+		std::memcpy(allocate(size + 1), shared, (size + 1) * sizeof(cell));
+		release_interned_data(shared);
+	}
+}
+
+void dyn_object::release_interned() noexcept
+{
+	cell *data = array_data;
+	reset_array();
+	interned = false;
+	release_interned_data(data);
+}
+
 dyn_object::dyn_object(cell value, tag_ptr tag, bool assign) noexcept : rank(0), cell_value(value), tag(tag)
 {
 	if(assign)
@@ -205,11 +455,12 @@ dyn_object::dyn_object(const cell *arr, cell size, tag_ptr tag) : rank(1), tag(t
 {
 	if(arr != nullptr)
 	{
-		array_data = new cell[size + 2];
+		allocate(size + 2);
 		std::memcpy(array_data + 1, arr, size * sizeof(cell));
 		array_data[size + 1] = 0;
 	}else{
-		array_data = new cell[size + 2]();
+		allocate(size + 2);
+		std::fill_n(array_data, size + 2, 0);
 	}
 	array_data[0] = size + 1;
 	init_op();
@@ -217,16 +468,21 @@ dyn_object::dyn_object(const cell *arr, cell size, tag_ptr tag) : rank(1), tag(t
 
 dyn_object::dyn_object(const dyn_object &obj, bool assign) : rank(obj.rank), tag(obj.tag)
 {
+	if(obj.interned)
+	{
+		share(obj);
+		return;
+	}
 	if(rank > 0)
 	{
 		if(obj.array_data != nullptr)
 		{
 			cell size = obj.data_size();
-			array_data = new cell[size + 1];
+			allocate(size + 1);
 			std::memcpy(array_data, obj.array_data, size * sizeof(cell));
 			array_data[size] = 0;
 		}else{
-			array_data = nullptr;
+			reset_array();
 		}
 	}else{
 		cell_value = obj.cell_value;
@@ -263,11 +519,11 @@ cell dyn_object::array_start() const
 	{
 		return 0;
 	}else{
-		cell *b = array_data + 1;
+		const cell *b = array_data + 1;
 		auto dim = rank;
 		while(dim > 1)
 		{
-			b = (cell*)((char*)b + *b);
+			b = (const cell*)((const char*)b + *b);
 			dim--;
 		}
 		return b - array_data;
@@ -321,6 +577,7 @@ void dyn_object::set_cell(const cell *indices, cell num_indices, cell value)
 
 cell *dyn_object::get_array(const cell *indices, cell num_indices, cell &size)
 {
+	unshare();
 	return const_cast<cell*>(static_cast<const dyn_object*>(this)->get_array(indices, num_indices, size));
 }
 
@@ -410,6 +667,7 @@ cell dyn_object::get_array(const cell *indices, cell num_indices, cell *arr, cel
 
 cell *dyn_object::get_cell_addr(const cell *indices, cell num_indices)
 {
+	unshare();
 	return const_cast<cell*>(static_cast<const dyn_object*>(this)->get_cell_addr(indices, num_indices));
 }
 
@@ -511,6 +769,7 @@ void dyn_object::load(AMX *amx, cell amx_addr)
 {
 	if(is_array())
 	{
+		unshare();
 		cell size = data_size() - 1;
 		cell *addr = amx_GetAddrSafe(amx, amx_addr);
 		std::memcpy(array_data + 1, addr, size * sizeof(cell));
@@ -521,6 +780,7 @@ void dyn_object::load(AMX *amx, cell amx_addr)
 
 cell *dyn_object::begin()
 {
+	unshare();
 	if(is_cell())
 	{
 		return &cell_value;
@@ -531,6 +791,7 @@ cell *dyn_object::begin()
 
 cell *dyn_object::end()
 {
+	unshare();
 	if(is_cell())
 	{
 		return &cell_value + 1;
@@ -541,6 +802,7 @@ cell *dyn_object::end()
 
 cell *dyn_object::data_begin()
 {
+	unshare();
 	if(is_cell())
 	{
 		return &cell_value;
@@ -634,15 +896,12 @@ cell dyn_object::get_size(const cell *indices, cell num_indices) const
 	return end - begin;
 }
 
-template <class T>
-inline void hash_combine(size_t& seed, const T& v)
-{
-	std::hash<T> hasher;
-	seed ^= hasher(v) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
-}
-
 size_t dyn_object::get_hash() const
 {
+	if(interned)
+	{
+		return get_interned_header(array_data).hash;
+	}
 	size_t hash = 0;
 	if(empty()) return 0;
 
@@ -803,6 +1062,7 @@ bool dyn_object::struct_compatible(const dyn_object &obj) const noexcept
 
 bool dyn_object::operator==(const dyn_object &obj) const noexcept
 {
+	if(interned && obj.interned) return array_data == obj.array_data;
 	if(!tag_compatible(obj) || !struct_compatible(obj)) return false;
 	if(empty()) return true;
 	const cell *begin1 = begin();
@@ -820,6 +1080,7 @@ bool dyn_object::operator==(const dyn_object &obj) const noexcept
 
 bool dyn_object::operator!=(const dyn_object &obj) const noexcept
 {
+	if(interned && obj.interned) return array_data != obj.array_data;
 	if(!tag_compatible(obj) || !struct_compatible(obj)) return true;
 	if(empty()) return false;
 	const cell *begin1 = begin();
@@ -1190,23 +1451,33 @@ std::basic_string<cell> dyn_object::to_string() const
 dyn_object &dyn_object::operator=(const dyn_object &obj)
 {
 	if(this == &obj) return *this;
-	collect_op();
-	if(is_array())
+	if(interned)
 	{
-		delete[] array_data;
+		release_interned();
+	}else{
+		collect_op();
+		if(is_array())
+		{
+			deallocate();
+		}
 	}
 	rank = obj.rank;
 	tag = obj.tag;
+	if(obj.interned)
+	{
+		share(obj);
+		return *this;
+	}
 	if(rank > 0)
 	{
 		if(obj.array_data != nullptr)
 		{
 			cell size = obj.data_size();
-			array_data = new cell[size + 1];
+			allocate(size + 1);
 			std::memcpy(array_data, obj.array_data, size * sizeof(cell));
 			array_data[size] = 0;
 		}else{
-			array_data = nullptr;
+			reset_array();
 		}
 	}else{
 		cell_value = obj.cell_value;
@@ -1218,21 +1489,17 @@ dyn_object &dyn_object::operator=(const dyn_object &obj)
 dyn_object &dyn_object::operator=(dyn_object &&obj) noexcept
 {
 	if(this == &obj) return *this;
-	collect_op();
-	if(is_array())
-	{
-		delete[] array_data;
-	}
-	rank = obj.rank;
-	tag = obj.tag;
-	if(rank > 0)
+	if(interned)
 	{
-		array_data = obj.array_data;
+		release_interned();
 	}else{
-		cell_value = obj.cell_value;
+		collect_op();
+		if(is_array())
+		{
+			deallocate();
+		}
 	}
-	obj.array_data = nullptr;
-	obj.rank = 1;
+	take(obj);
 	return *this;
 }
 
@@ -1240,32 +1507,18 @@ void dyn_object::swap(dyn_object &other) noexcept
 {
 	if(this != &other)
 	{
-		if(is_cell())
-		{
-			if(other.is_cell())
-			{
-				std::swap(cell_value, other.cell_value);
-			}else{
-				cell c = cell_value;
-				array_data = other.array_data;
-				other.cell_value = c;
-			}
-		}else if(other.is_cell())
-		{
-			cell c = other.cell_value;
-			other.array_data = array_data;
-			cell_value = c;
-		}else{
-			std::swap(array_data, other.array_data);
-		}
-		std::swap(rank, other.rank);
-		std::swap(tag, other.tag);
+		dyn_object tmp(std::move(other));
+		other.take(*this);
+		take(tmp);
 	}
 }
 
 dyn_object::~dyn_object()
 {
-	if(!is_null())
+	if(interned)
+	{
+		release_interned();
+	}else if(!is_null())
 	{
 		if(is_array())
 		{
@@ -1273,13 +1526,13 @@ dyn_object::~dyn_object()
 			cell *end = this->end();
 			cell *data = array_data;
 			rank = 1;
-			array_data = nullptr;
+			reset_array();
 			collect_op(begin, end - begin);
-			delete[] data;
+			free_cells(data);
 		}else{
 			cell value = cell_value;
 			rank = 1;
-			array_data = nullptr;
+			reset_array();
 			collect_op(&value, 1);
 		}
 	}
@@ -10,6 +10,8 @@
 class dyn_object
 {
 	unsigned char rank;
+	// array_data points to a shared interned string, copied before any modification
+	bool interned = false;
 	union{
 		cell cell_value;
 		cell *array_data;
@@ -32,6 +34,10 @@ public:
 	dyn_object(AMX *amx, const cell *arr, cell size, cell size2, cell size3, cell tag_id);
 	dyn_object(const cell *str);
 
+	// returns a string object sharing its data with all interned strings of the same value
+	static dyn_object intern(const cell *str);
+	static cell string_size(const cell *str);
+
 	dyn_object(cell value, tag_ptr tag) noexcept : dyn_object(value, tag, true)
 	{
 
@@ -48,19 +54,16 @@ public:
 
 	dyn_object(const dyn_object &obj, tag_ptr new_tag) : dyn_object(obj, true)
 	{
+		if(new_tag != tag)
+		{
+			unshare();
+		}
 		tag = new_tag;
 	}
 
-	dyn_object(dyn_object &&obj) noexcept : rank(obj.rank), tag(obj.tag)
+	dyn_object(dyn_object &&obj) noexcept : rank(1), array_data(nullptr), tag(obj.tag)
 	{
-		if(rank > 0)
-		{
-			array_data = obj.array_data;
-		}else{
-			cell_value = obj.cell_value;
-		}
-		obj.array_data = nullptr;
-		obj.rank = 1;
+		take(obj);
 	}
 
 	bool tag_assignable(tag_ptr test_tag) const noexcept;
@@ -151,6 +154,11 @@ public:
 		return rank == 0;
 	}
 
+	bool is_interned() const
+	{
+		return interned;
+	}
+
 	cell get_rank() const
 	{
 		return is_null() ? -1 : static_cast<cell>(rank);
@@ -209,6 +217,37 @@ public:
 	~dyn_object();
 
 private:
+	// makes room for the array data of this object, which must not own any data;
+	// small arrays are taken from pooled blocks instead of being allocated individually
+	cell *allocate(cell size);
+	void deallocate() noexcept;
+
+	void reset_array() noexcept
+	{
+		array_data = nullptr;
+	}
+
+	// moves the value of obj to this object, which must not own any data
+	void take(dyn_object &obj) noexcept
+	{
+		rank = obj.rank;
+		tag = obj.tag;
+		if(rank > 0)
+		{
+			array_data = obj.array_data;
+		}else{
+			cell_value = obj.cell_value;
+		}
+		interned = obj.interned;
+		obj.reset_array();
+		obj.rank = 1;
+		obj.interned = false;
+	}
+
+	void share(const dyn_object &obj) noexcept;
+	void unshare();
+	void release_interned() noexcept;
+
 	dyn_object(cell value, tag_ptr tag, bool assign) noexcept;
 	dyn_object(const dyn_object &obj, bool assign);
 	bool init_op();
@@ -2,12 +2,13 @@
 #define OBJECT_POOL_H_INCLUDED
 
 #include "main.h"
-#include "utils/shared_id_set_pool.h"
+#include "utils/flat_ptr_map.h"
 #include "sdk/amx/amx.h"
 #include <vector>
 #include <unordered_map>
 #include <type_traits>
 #include <memory>
+#include <stdexcept>
 
 template <class ObjType>
 class object_pool
@@ -224,51 +225,169 @@ public:
 	typedef decltype(&static_cast<ObjType*>(nullptr)->operator[](0)) inner_ptr;
 	typedef decltype(&static_cast<const ObjType*>(nullptr)->operator[](0)) const_inner_ptr;
 
-	typedef aux::shared_id_set_pool<ref_container> list_type;
+	struct list_entry
+	{
+		std::shared_ptr<ref_container> ptr;
+		bool global = false;
+		cell id = 0;
+	};
+
+	// local and global objects share one table, so validating an id needs a single lookup
+	typedef aux::flat_ptr_map<ref_container, list_entry> list_type;
 
 private:
-	list_type global_object_list;
-	list_type local_object_list;
+	// in slot mode, an id consists of a slot index and the generation of the slot
+	static constexpr unsigned id_index_bits = 22;
+	static constexpr ucell id_index_mask = (static_cast<ucell>(1) << id_index_bits) - 1;
+	static constexpr ucell id_max_generation = (static_cast<ucell>(1) << (sizeof(cell) * 8 - 1 - id_index_bits)) - 1;
+	static constexpr size_t no_slot = static_cast<size_t>(-1);
+
+	struct id_slot
+	{
+		ref_container *ptr;
+		ucell generation;
+		size_t next_free;
+	};
+
+	list_type object_list;
+	std::vector<ref_container*> local_candidates;
+	size_t global_count = 0;
 	std::unordered_map<const_inner_ptr, const ref_container*> inner_cache;
 
+	bool slot_ids;
+	std::vector<id_slot> id_slots;
+	size_t first_free_slot = no_slot;
+
+	cell allocate_id(ref_container *ptr)
+	{
+		size_t index = first_free_slot;
+		if(index != no_slot)
+		{
+			first_free_slot = id_slots[index].next_free;
+		}else{
+			if(id_slots.size() > id_index_mask)
+			{
+				throw std::length_error("too many objects in the pool");
+			}
+			index = id_slots.size();
+			id_slots.push_back(id_slot{nullptr, 1, no_slot});
+		}
+		auto &slot = id_slots[index];
+		slot.ptr = ptr;
+		return static_cast<cell>((slot.generation << id_index_bits) | index);
+	}
+
+	void free_id(cell id)
+	{
+		size_t index = id & id_index_mask;
+		auto &slot = id_slots[index];
+		slot.ptr = nullptr;
+		slot.generation = slot.generation % id_max_generation + 1;
+		slot.next_free = first_free_slot;
+		first_free_slot = index;
+	}
+
+	ref_container *find_by_id(cell id) const
+	{
+		if(slot_ids)
+		{
+			size_t index = id & id_index_mask;
+			if(index < id_slots.size() && id_slots[index].generation == (static_cast<ucell>(id) >> id_index_bits))
+			{
+				return id_slots[index].ptr;
+			}
+			return nullptr;
+		}
+		auto ptr = reinterpret_cast<ref_container*>(id);
+		if(object_list.find(ptr))
+		{
+			return ptr;
+		}
+		return nullptr;
+	}
+
+	object_ptr add_local(std::shared_ptr<ref_container> &&obj)
+	{
+		auto ptr = obj.get();
+		list_entry entry;
+		entry.ptr = std::move(obj);
+		size_t old_size = object_list.size();
+		auto &added = object_list.emplace(ptr, std::move(entry));
+		if(object_list.size() != old_size)
+		{
+			if(slot_ids)
+			{
+				try{
+					added.id = allocate_id(ptr);
+				}catch(...)
+				{
+					// the object would not be reachable by any id or collected
+					object_list.extract(ptr, entry);
+					throw;
+				}
+			}
+			local_candidates.push_back(ptr);
+		}
+		return *ptr;
+	}
+
+	bool remove_entry(ref_container *obj)
+	{
+		list_entry entry;
+		if(object_list.extract(obj, entry))
+		{
+			if(entry.global)
+			{
+				global_count--;
+			}
+			if(slot_ids)
+			{
+				free_id(entry.id);
+			}
+			return true;
+		}
+		return false;
+	}
+
 public:
+	// slot_ids selects (index, generation) ids instead of object addresses;
+	// at most 2^22 objects can be alive at once then, and adding more throws std::length_error
+	explicit object_pool(bool slot_ids = false) : slot_ids(slot_ids)
+	{
+
+	}
+
 	object_ptr add()
 	{
-		return *local_object_list.add();
+		return add_local(std::make_shared<ref_container>());
 	}
 
 	object_ptr add(ObjType &&obj)
 	{
-		return *local_object_list.emplace(std::move(obj));
+		return add_local(std::make_shared<ref_container>(std::move(obj)));
 	}
 
 	object_ptr add(ref_container &&obj)
 	{
-		return *local_object_list.add(std::move(obj));
+		return add_local(std::make_shared<ref_container>(std::move(obj)));
 	}
 
 	object_ptr add(std::shared_ptr<ref_container> &&obj)
 	{
-		return *local_object_list.add(std::move(obj));
+		return add_local(std::move(obj));
 	}
 
-	/*object_ptr add(std::unique_ptr<ref_container> &&obj)
-	{
-		return *local_object_list.add(std::move(obj));
-	}*/
-
 	template <class... Args>
 	object_ptr emplace(Args &&...args)
 	{
-		return *local_object_list.emplace(std::forward<Args>(args)...);
+		return add_local(std::make_shared<ref_container>(std::forward<Args>(args)...));
 	}
 
 	template <class Type, class... Args>
 	object_ptr emplace_derived(Args &&...args)
 	{
-		return *local_object_list.template emplace_derived<Type>(std::forward<Args>(args)...);
+		return add_local(std::make_shared<Type>(std::forward<Args>(args)...));
 	}
-
 	cell get_address(AMX *amx, const_object_ptr obj) const
 	{
 		unsigned char *data = amx_GetData(amx);
@@ -304,11 +423,11 @@ public:
 		{
 			if(local)
 			{
-				auto it = local_object_list.find(&obj);
-				if(it != local_object_list.end())
+				auto entry = object_list.find(&obj);
+				if(entry && !entry->global)
 				{
-					auto ptr = local_object_list.extract(it);
-					global_object_list.add(std::move(ptr));
+					entry->global = true;
+					global_count++;
 				}
 			}
 			return true;
@@ -322,11 +441,12 @@ public:
 		{
 			if(obj.local())
 			{
-				auto it = global_object_list.find(&obj);
-				if(it != global_object_list.end())
+				auto entry = object_list.find(&obj);
+				if(entry && entry->global)
 				{
-					auto ptr = global_object_list.extract(it);
-					local_object_list.add(std::move(ptr));
+					entry->global = false;
+					global_count--;
+					local_candidates.push_back(&obj);
 				}
 			}
 			return true;
@@ -352,35 +472,14 @@ public:
 
 	bool remove(object_ptr obj)
 	{
-		auto it = global_object_list.find(&obj);
-		if(it != global_object_list.end())
-		{
-			global_object_list.erase(it);
-			return true;
-		}
-		it = local_object_list.find(&obj);
-		if(it != local_object_list.end())
-		{
-			local_object_list.erase(it);
-			return true;
-		}
-		return false;
+		return remove_entry(&obj);
 	}
 
 	bool remove_by_id(cell id)
 	{
-		auto obj = reinterpret_cast<ref_container*>(id);
-		auto it = global_object_list.find(obj);
-		if(it != global_object_list.end())
-		{
-			global_object_list.erase(it);
-			return true;
-		}
-		it = local_object_list.find(obj);
-		if(it != local_object_list.end())
+		if(auto obj = find_by_id(id))
 		{
-			local_object_list.erase(it);
-			return true;
+			return remove_entry(obj);
 		}
 		return false;
 	}
@@ -388,44 +487,50 @@ public:
 	void clear()
 	{
 		inner_cache.clear();
-		auto tmp = std::move(local_object_list);
-		tmp.clear();
-		auto list = std::move(global_object_list);
+		local_candidates.clear();
+		global_count = 0;
+		id_slots.clear();
+		first_free_slot = no_slot;
+		auto list = std::move(object_list);
 		list.clear();
 	}
 
 	void clear_tmp()
 	{
 		inner_cache.clear();
-		auto tmp = std::move(local_object_list);
-		tmp.clear();
+		std::vector<ref_container*> candidates;
+		candidates.swap(local_candidates);
+		// the objects are destroyed only after all of them are removed from the pool
+		std::vector<list_entry> removed;
+		for(auto ptr : candidates)
+		{
+			auto entry = object_list.find(ptr);
+			if(entry && !entry->global)
+			{
+				removed.emplace_back();
+				object_list.extract(ptr, removed.back());
+				if(slot_ids)
+				{
+					free_id(removed.back().id);
+				}
+			}
+		}
 	}
 
 	bool get_by_id(cell id, ref_container *&obj)
 	{
-		obj = reinterpret_cast<ref_container*>(id);
-
-		if(local_object_list.find(obj) != local_object_list.end())
-		{
-			return true;
-		}
-		if(global_object_list.find(obj) != global_object_list.end())
+		if(auto ptr = find_by_id(id))
 		{
+			obj = ptr;
 			return true;
 		}
+		obj = reinterpret_cast<ref_container*>(id);
 		return false;
 	}
 
 	bool get_by_id(cell id, ObjType *&obj)
 	{
-		auto ptr = reinterpret_cast<ref_container*>(id);
-
-		if(local_object_list.find(ptr) != local_object_list.end())
-		{
-			obj = *ptr;
-			return true;
-		}
-		if(global_object_list.find(ptr) != global_object_list.end())
+		if(auto ptr = find_by_id(id))
 		{
 			obj = *ptr;
 			return true;
@@ -436,13 +541,14 @@ public:
 
 	bool get_by_id(cell id, std::shared_ptr<ref_container> &obj)
 	{
-		if(local_object_list.get_by_id(id, obj))
+		auto ptr = slot_ids ? find_by_id(id) : reinterpret_cast<ref_container*>(id);
+		if(ptr)
 		{
-			return true;
-		}
-		if(global_object_list.get_by_id(id, obj))
-		{
-			return true;
+			if(auto entry = object_list.find(ptr))
+			{
+				obj = entry->ptr;
+				return true;
+			}
 		}
 		return false;
 	}
@@ -471,20 +577,22 @@ public:
 
 	cell get_id(const_object_ptr obj) const
 	{
+		if(slot_ids)
+		{
+			if(auto entry = object_list.find(&obj))
+			{
+				return entry->id;
+			}
+			return 0;
+		}
 		return reinterpret_cast<cell>(&obj);
 	}
 
 	std::shared_ptr<ref_container> get(object_ptr obj)
 	{
-		auto it = local_object_list.find(&obj);
-		if(it != local_object_list.end())
+		if(auto entry = object_list.find(&obj))
 		{
-			return it->second;
-		}
-		it = global_object_list.find(&obj);
-		if(it != global_object_list.end())
-		{
-			return it->second;
+			return entry->ptr;
 		}
 		return {};
 	}
@@ -493,27 +601,17 @@ public:
 	{
 		obj = reinterpret_cast<ref_container*>(amx_GetData(amx) + addr);
 
-		auto it = local_object_list.find(obj);
-		if(it != local_object_list.end())
-		{
-			return true;
-		}
-		it = global_object_list.find(obj);
-		if(it != global_object_list.end())
-		{
-			return true;
-		}
-		return false;
+		return object_list.find(obj) != nullptr;
 	}
 
 	size_t local_size() const
 	{
-		return local_object_list.size();
+		return object_list.size() - global_count;
 	}
 
 	size_t global_size() const
 	{
-		return global_object_list.size();
+		return global_count;
 	}
 };
 
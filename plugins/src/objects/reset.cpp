@@ -2,9 +2,139 @@
 #include "main.h"
 #include "fixes/linux.h"
 #include <cstring>
+#include <vector>
+#include <mutex>
 
 namespace amx
 {
+	constexpr size_t min_snapshot_class = 6;
+	constexpr size_t max_snapshot_class = 20;
+	constexpr size_t max_snapshot_cached = 16 * 1024 * 1024;
+
+	struct snapshot_pool
+	{
+		std::mutex mutex;
+		std::vector<unsigned char*> buffers[max_snapshot_class - min_snapshot_class + 1];
+		size_t hits = 0;
+		size_t misses = 0;
+		size_t cached = 0;
+	};
+
+	// never destroyed, since snapshots may be released during static destruction
+	static snapshot_pool &get_snapshot_pool()
+	{
+		static snapshot_pool *pool = new snapshot_pool();
+		return *pool;
+	}
+
+	snapshot_ptr alloc_snapshot(size_t size)
+	{
+		size_t size_class = min_snapshot_class;
+		while(size_class <= max_snapshot_class && (static_cast<size_t>(1) << size_class) < size)
+		{
+			size_class++;
+		}
+		auto &pool = get_snapshot_pool();
+		if(size_class > max_snapshot_class)
+		{
+			{
+				std::lock_guard<std::mutex> lock(pool.mutex);
+				pool.misses++;
+			}
+			return snapshot_ptr(new unsigned char[size], snapshot_deleter(size));
+		}
+		size_t capacity = static_cast<size_t>(1) << size_class;
+		{
+			std::lock_guard<std::mutex> lock(pool.mutex);
+			auto &buffers = pool.buffers[size_class - min_snapshot_class];
+			if(!buffers.empty())
+			{
+				unsigned char *buffer = buffers.back();
+				buffers.pop_back();
+				pool.cached -= capacity;
+				pool.hits++;
+				return snapshot_ptr(buffer, snapshot_deleter(capacity));
+			}
+			pool.misses++;
+		}
+		return snapshot_ptr(new unsigned char[capacity], snapshot_deleter(capacity));
+	}
+
+	void snapshot_deleter::operator()(unsigned char *buffer) const
+	{
+		if((capacity & (capacity - 1)) == 0 && capacity <= (static_cast<size_t>(1) << max_snapshot_class))
+		{
+			auto &pool = get_snapshot_pool();
+			std::lock_guard<std::mutex> lock(pool.mutex);
+			if(pool.cached + capacity <= max_snapshot_cached)
+			{
+				size_t size_class = min_snapshot_class;
+				while((static_cast<size_t>(1) << size_class) < capacity)
+				{
+					size_class++;
+				}
+				pool.buffers[size_class - min_snapshot_class].push_back(buffer);
+				pool.cached += capacity;
+				return;
+			}
+		}
+		delete[] buffer;
+	}
+
+	size_t snapshot_stats(size_t &hits, size_t &misses)
+	{
+		auto &pool = get_snapshot_pool();
+		std::lock_guard<std::mutex> lock(pool.mutex);
+		hits = pool.hits;
+		misses = pool.misses;
+		return pool.cached;
+	}
+
+	void clear_snapshots()
+	{
+		auto &pool = get_snapshot_pool();
+		std::lock_guard<std::mutex> lock(pool.mutex);
+		for(auto &buffers : pool.buffers)
+		{
+			for(unsigned char *buffer : buffers)
+			{
+				delete[] buffer;
+			}
+			std::vector<unsigned char*>().swap(buffers);
+		}
+		pool.cached = 0;
+	}
+
+	// checks that no cell in the context (its heap, stack and registers) points to the data outside of it
+	static bool is_context_closed(AMX *amx, unsigned char *dat)
+	{
+		if(amx->reset_hea == amx->hlw && amx->reset_stk == amx->stp)
+		{
+			return true;
+		}
+		auto is_outer = [=](cell value)
+		{
+			return (value >= amx->hlw && value < amx->reset_hea) || (value >= amx->reset_stk && value < amx->stp);
+		};
+		if(is_outer(amx->pri) || is_outer(amx->alt))
+		{
+			return false;
+		}
+		auto begin = reinterpret_cast<const cell*>(dat + amx->reset_hea);
+		auto end = reinterpret_cast<const cell*>(dat + amx->hea);
+		for(auto it = begin; it < end; ++it)
+		{
+			if(is_outer(*it)) return false;
+		}
+		begin = reinterpret_cast<const cell*>(dat + amx->stk);
+		end = reinterpret_cast<const cell*>(dat + amx->reset_stk);
+		for(auto it = begin; it < end; ++it)
+		{
+			if(is_outer(*it)) return false;
+		}
+		return true;
+	}
+
 	reset::reset(AMX* amx, bool context, restore_range restore_heap, restore_range restore_stack) : amx(amx::load(amx)), cip(amx->cip), frm(amx->frm), pri(amx->pri), alt(amx->alt), hea(amx->hea), reset_hea(amx->reset_hea), stk(amx->stk), reset_stk(amx->reset_stk), restore_heap(restore_heap), restore_stack(restore_stack)
 	{
 		if(context)
@@ -17,8 +147,21 @@ namespace amx
 
 		dat = amx_GetData(amx);
 
-		unsigned char *h;
-		size_t heap_size;
+		if(restore_heap == restore_range::automatic || restore_stack == restore_range::automatic)
+		{
+			// capturing the full range of one part makes its outer data reachable from the snapshot
+			bool context_only = restore_heap != restore_range::full && restore_stack != restore_range::full && is_context_closed(amx, dat);
+			restore_range resolved = context_only ? restore_range::context : restore_range::full;
+			if(restore_heap == restore_range::automatic)
+			{
+				this->restore_heap = restore_heap = resolved;
+			}
+			if(restore_stack == restore_range::automatic)
+			{
+				this->restore_stack = restore_stack = resolved;
+			}
+		}
+
 		switch(restore_heap)
 		{
 			case restore_range::none:
@@ -26,21 +169,20 @@ namespace amx
 				break;
 			case restore_range::frame:
 			case restore_range::context:
-				h = dat + reset_hea;
 				heap_size = hea - reset_hea;
 				break;
+			case restore_range::automatic:
+				// resolved above; capturing everything is always correct
 			case restore_range::full:
-				h = dat + amx->hlw;
 				heap_size = hea - amx->hlw;
 				break;
 		}
 		if(heap_size > 0)
 		{
-			heap = std::make_unique<unsigned char[]>(heap_size);
-			std::memcpy(heap.get(), h, heap_size);
+			heap = alloc_snapshot(heap_size);
+			std::memcpy(heap.get(), dat + hea - heap_size, heap_size);
 		}
 
-		size_t stack_size;
 		switch(restore_stack)
 		{
 			case restore_range::none:
@@ -53,6 +195,8 @@ namespace amx
 			case restore_range::context:
 				stack_size = reset_stk - stk;
 				break;
+			case restore_range::automatic:
+				// resolved above; capturing everything is always correct
 			case restore_range::full:
 				stack_size = amx->stp - stk;
 				break;
@@ -60,7 +204,7 @@ namespace amx
 		if(stack_size > 0)
 		{
 			unsigned char *s = dat + stk;
-			stack = std::make_unique<unsigned char[]>(stack_size);
+			stack = alloc_snapshot(stack_size);
 			std::memcpy(stack.get(), s, stack_size);
 			if(restore_stack == restore_range::frame)
 			{
@@ -77,6 +221,8 @@ namespace amx
 		if(!obj || !obj->valid()) return false;
 		auto amx = obj->get();
 		amx::restore(amx, std::move(context));
+		heap = nullptr;
+		stack = nullptr;
 		return true;
 	}
 
@@ -102,59 +248,18 @@ namespace amx
 
 		if(heap)
 		{
-			unsigned char *h;
-			size_t heap_size;
-			switch(restore_heap)
-			{
-				case restore_range::none:
-					heap_size = 0;
-					break;
-				case restore_range::frame:
-				case restore_range::context:
-					h = dat + reset_hea;
-					heap_size = hea - reset_hea;
-					break;
-				case restore_range::full:
-					h = dat + amx->hlw;
-					heap_size = hea - amx->hlw;
-					break;
-			}
-			if(heap_size > 0)
-			{
-				std::memcpy(h, heap.get(), heap_size);
-			}
+			std::memcpy(dat + hea - heap_size, heap.get(), heap_size);
 		}
 
 		if(stack)
 		{
-			size_t stack_size;
-			switch(restore_stack)
-			{
-				case restore_range::none:
-					stack_size = 0;
-					break;
-				case restore_range::frame:
-					stack_size = frm + sizeof(cell) * 2 - stk;
-					stack_size += sizeof(cell) + reinterpret_cast<cell&>(stack[stack_size]);
-					break;
-				case restore_range::context:
-					stack_size = reset_stk - stk;
-					break;
-				case restore_range::full:
-					stack_size = amx->stp - stk;
-					break;
-			}
-			if(stack_size > 0)
-			{
-				unsigned char *s = dat + stk;
-				std::memcpy(s, stack.get(), stack_size);
-			}
+			std::memcpy(dat + stk, stack.get(), stack_size);
 		}
 
 		return true;
 	}
 
-	reset::reset(reset &&obj) : context(std::move(obj.context)), amx(obj.amx), cip(obj.cip), frm(obj.frm), pri(obj.pri), alt(obj.alt), hea(obj.hea), reset_hea(obj.reset_hea), heap(std::move(obj.heap)), stk(obj.stk), reset_stk(obj.reset_stk), stack(std::move(obj.stack)), restore_heap(obj.restore_heap), restore_stack(obj.restore_stack)
+	reset::reset(reset &&obj) : context(std::move(obj.context)), amx(obj.amx), cip(obj.cip), frm(obj.frm), pri(obj.pri), alt(obj.alt), hea(obj.hea), reset_hea(obj.reset_hea), heap(std::move(obj.heap)), stk(obj.stk), reset_stk(obj.reset_stk), stack(std::move(obj.stack)), heap_size(obj.heap_size), stack_size(obj.stack_size), restore_heap(obj.restore_heap), restore_stack(obj.restore_stack)
 	{
 
 	}
@@ -170,6 +275,8 @@ namespace amx
 		hea = obj.hea, reset_hea = obj.reset_hea;
 		heap = std::move(obj.heap);
 		stack = std::move(obj.stack);
+		heap_size = obj.heap_size;
+		stack_size = obj.stack_size;
 		restore_heap = obj.restore_heap;
 		restore_stack = obj.restore_stack;
 		return *this;
@@ -15,13 +15,41 @@ namespace amx
 		frame = 1,
 		context = 2,
 		full = 3,
+		// context if nothing in it refers to the outer data, full otherwise
+		automatic = 4,
 	};
 
+	// returns the buffer to the snapshot pool
+	struct snapshot_deleter
+	{
+		size_t capacity;
+
+		snapshot_deleter() : capacity(0)
+		{
+
+		}
+
+		snapshot_deleter(size_t capacity) : capacity(capacity)
+		{
+
+		}
+
+		void operator()(unsigned char *buffer) const;
+	};
+
+	typedef std::unique_ptr<unsigned char[], snapshot_deleter> snapshot_ptr;
+
+	// heap and stack snapshots are allocated from a shared pool of power-of-two size classes
+	snapshot_ptr alloc_snapshot(size_t size);
+	size_t snapshot_stats(size_t &hits, size_t &misses);
+	void clear_snapshots();
+
 	struct reset
 	{
 		cell cip, frm, pri, alt, hea, reset_hea, stk, reset_stk;
 		restore_range restore_heap, restore_stack;
-		std::unique_ptr<unsigned char[]> heap, stack;
+		snapshot_ptr heap, stack;
+		size_t heap_size = 0, stack_size = 0;
 		amx::context context;
 
 		amx::handle amx;
@@ -37,6 +65,11 @@ namespace amx
 
 		bool restore();
 		bool restore_no_context() const;
+
+		size_t captured_size() const
+		{
+			return heap_size + stack_size;
+		}
 	};
 }
 
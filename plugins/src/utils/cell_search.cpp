@@ -0,0 +1,345 @@
+#include "cell_search.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define CELL_SEARCH_X86
+#endif
+
+#ifdef CELL_SEARCH_X86
+
+#include <immintrin.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#define CELL_SEARCH_TARGET(isa)
+
+static void get_cpuid(int info[4], int leaf)
+{
+	__cpuidex(info, leaf, 0);
+}
+
+static unsigned long long get_xcr0()
+{
+	return _xgetbv(0);
+}
+
+static unsigned first_bit(unsigned mask)
+{
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return index;
+}
+
+static unsigned last_bit(unsigned mask)
+{
+	unsigned long index;
+	_BitScanReverse(&index, mask);
+	return index;
+}
+#else
+#include <cpuid.h>
+#define CELL_SEARCH_TARGET(isa) __attribute__((target(isa)))
+
+static void get_cpuid(int info[4], int leaf)
+{
+	unsigned int a, b, c, d;
+	__cpuid_count(leaf, 0, a, b, c, d);
+	info[0] = a;
+	info[1] = b;
+	info[2] = c;
+	info[3] = d;
+}
+
+static unsigned long long get_xcr0()
+{
+	unsigned int eax, edx;
+	__asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return (static_cast<unsigned long long>(edx) << 32) | eax;
+}
+
+static unsigned first_bit(unsigned mask)
+{
+	return __builtin_ctz(mask);
+}
+
+static unsigned last_bit(unsigned mask)
+{
+	return 31 - __builtin_clz(mask);
+}
+#endif
+
+#endif
+
+static size_t find_cell_scalar(const cell *data, size_t size, cell value)
+{
+	for(size_t i = 0; i < size; i++)
+	{
+		if(data[i] == value)
+		{
+			return i;
+		}
+	}
+	return size;
+}
+
+static size_t find_last_cell_scalar(const cell *data, size_t size, cell value)
+{
+	for(size_t i = size; i > 0; i--)
+	{
+		if(data[i - 1] == value)
+		{
+			return i - 1;
+		}
+	}
+	return size;
+}
+
+static size_t count_cell_scalar(const cell *data, size_t size, cell value)
+{
+	size_t count = 0;
+	for(size_t i = 0; i < size; i++)
+	{
+		count += data[i] == value;
+	}
+	return count;
+}
+
+static size_t find_any_cell_scalar(const cell *data, size_t size, const cell *values)
+{
+	for(size_t i = 0; i < size; i++)
+	{
+		cell c = data[i];
+		if(c == values[0] || c == values[1] || c == values[2] || c == values[3])
+		{
+			return i;
+		}
+	}
+	return size;
+}
+
+#ifdef CELL_SEARCH_X86
+
+CELL_SEARCH_TARGET("sse2")
+static size_t find_cell_sse2(const cell *data, size_t size, cell value)
+{
+	__m128i key = _mm_set1_epi32(value);
+	size_t i = 0;
+	for(; i + 4 <= size; i += 4)
+	{
+		__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+		unsigned mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(block, key)));
+		if(mask)
+		{
+			return i + first_bit(mask);
+		}
+	}
+	size_t rest = find_cell_scalar(data + i, size - i, value);
+	return rest == size - i ? size : i + rest;
+}
+
+CELL_SEARCH_TARGET("sse2")
+static size_t find_last_cell_sse2(const cell *data, size_t size, cell value)
+{
+	__m128i key = _mm_set1_epi32(value);
+	size_t i = size;
+	for(; i >= 4; i -= 4)
+	{
+		__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i - 4));
+		unsigned mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(block, key)));
+		if(mask)
+		{
+			return i - 4 + last_bit(mask);
+		}
+	}
+	size_t rest = find_last_cell_scalar(data, i, value);
+	return rest == i ? size : rest;
+}
+
+CELL_SEARCH_TARGET("sse2")
+static size_t count_cell_sse2(const cell *data, size_t size, cell value)
+{
+	__m128i key = _mm_set1_epi32(value);
+	__m128i counts = _mm_setzero_si128();
+	size_t i = 0;
+	for(; i + 4 <= size; i += 4)
+	{
+		__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+		// matching lanes are -1
+		counts = _mm_sub_epi32(counts, _mm_cmpeq_epi32(block, key));
+	}
+	alignas(16) unsigned int lanes[4];
+	_mm_store_si128(reinterpret_cast<__m128i*>(lanes), counts);
+	size_t count = static_cast<size_t>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+	return count + count_cell_scalar(data + i, size - i, value);
+}
+
+CELL_SEARCH_TARGET("sse2")
+static size_t find_any_cell_sse2(const cell *data, size_t size, const cell *values)
+{
+	__m128i key0 = _mm_set1_epi32(values[0]);
+	__m128i key1 = _mm_set1_epi32(values[1]);
+	__m128i key2 = _mm_set1_epi32(values[2]);
+	__m128i key3 = _mm_set1_epi32(values[3]);
+	size_t i = 0;
+	for(; i + 4 <= size; i += 4)
+	{
+		__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+		__m128i eq = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi32(block, key0), _mm_cmpeq_epi32(block, key1)), _mm_or_si128(_mm_cmpeq_epi32(block, key2), _mm_cmpeq_epi32(block, key3)));
+		unsigned mask = _mm_movemask_ps(_mm_castsi128_ps(eq));
+		if(mask)
+		{
+			return i + first_bit(mask);
+		}
+	}
+	size_t rest = find_any_cell_scalar(data + i, size - i, values);
+	return rest == size - i ? size : i + rest;
+}
+
+CELL_SEARCH_TARGET("avx2")
+static size_t find_cell_avx2(const cell *data, size_t size, cell value)
+{
+	__m256i key = _mm256_set1_epi32(value);
+	size_t i = 0;
+	for(; i + 8 <= size; i += 8)
+	{
+		__m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+		unsigned mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(block, key)));
+		if(mask)
+		{
+			return i + first_bit(mask);
+		}
+	}
+	size_t rest = find_cell_scalar(data + i, size - i, value);
+	return rest == size - i ? size : i + rest;
+}
+
+CELL_SEARCH_TARGET("avx2")
+static size_t find_last_cell_avx2(const cell *data, size_t size, cell value)
+{
+	__m256i key = _mm256_set1_epi32(value);
+	size_t i = size;
+	for(; i >= 8; i -= 8)
+	{
+		__m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i - 8));
+		unsigned mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(block, key)));
+		if(mask)
+		{
+			return i - 8 + last_bit(mask);
+		}
+	}
+	size_t rest = find_last_cell_scalar(data, i, value);
+	return rest == i ? size : rest;
+}
+
+CELL_SEARCH_TARGET("avx2")
+static size_t count_cell_avx2(const cell *data, size_t size, cell value)
+{
+	__m256i key = _mm256_set1_epi32(value);
+	__m256i counts = _mm256_setzero_si256();
+	size_t i = 0;
+	for(; i + 8 <= size; i += 8)
+	{
+		__m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+		counts = _mm256_sub_epi32(counts, _mm256_cmpeq_epi32(block, key));
+	}
+	alignas(32) unsigned int lanes[8];
+	_mm256_store_si256(reinterpret_cast<__m256i*>(lanes), counts);
+	size_t count = 0;
+	for(unsigned int lane : lanes)
+	{
+		count += lane;
+	}
+	return count + count_cell_scalar(data + i, size - i, value);
+}
+
+CELL_SEARCH_TARGET("avx2")
+static size_t find_any_cell_avx2(const cell *data, size_t size, const cell *values)
+{
+	__m256i key0 = _mm256_set1_epi32(values[0]);
+	__m256i key1 = _mm256_set1_epi32(values[1]);
+	__m256i key2 = _mm256_set1_epi32(values[2]);
+	__m256i key3 = _mm256_set1_epi32(values[3]);
+	size_t i = 0;
+	for(; i + 8 <= size; i += 8)
+	{
+		__m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+		__m256i eq = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi32(block, key0), _mm256_cmpeq_epi32(block, key1)), _mm256_or_si256(_mm256_cmpeq_epi32(block, key2), _mm256_cmpeq_epi32(block, key3)));
+		unsigned mask = _mm256_movemask_ps(_mm256_castsi256_ps(eq));
+		if(mask)
+		{
+			return i + first_bit(mask);
+		}
+	}
+	size_t rest = find_any_cell_scalar(data + i, size - i, values);
+	return rest == size - i ? size : i + rest;
+}
+
+#endif
+
+struct search_impl
+{
+	size_t(*find)(const cell*, size_t, cell);
+	size_t(*find_last)(const cell*, size_t, cell);
+	size_t(*count)(const cell*, size_t, cell);
+	size_t(*find_any)(const cell*, size_t, const cell*);
+};
+
+static search_impl select_impl()
+{
+#ifdef CELL_SEARCH_X86
+	int info[4];
+	get_cpuid(info, 0);
+	int max_leaf = info[0];
+	if(max_leaf >= 1)
+	{
+		get_cpuid(info, 1);
+		bool sse2 = (info[3] & (1 << 26)) != 0;
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		bool avx = (info[2] & (1 << 28)) != 0;
+		if(max_leaf >= 7 && osxsave && avx && (get_xcr0() & 6) == 6)
+		{
+			get_cpuid(info, 7);
+			if(info[1] & (1 << 5))
+			{
+				return {find_cell_avx2, find_last_cell_avx2, count_cell_avx2, find_any_cell_avx2};
+			}
+		}
+		if(sse2)
+		{
+			return {find_cell_sse2, find_last_cell_sse2, count_cell_sse2, find_any_cell_sse2};
+		}
+	}
+#endif
+	return {find_cell_scalar, find_last_cell_scalar, count_cell_scalar, find_any_cell_scalar};
+}
+
+static const search_impl &get_impl()
+{
+	static const search_impl impl = select_impl();
+	return impl;
+}
+
+size_t aux::find_cell(const cell *data, size_t size, cell value)
+{
+	return get_impl().find(data, size, value);
+}
+
+size_t aux::find_last_cell(const cell *data, size_t size, cell value)
+{
+	return get_impl().find_last(data, size, value);
+}
+
+size_t aux::count_cell(const cell *data, size_t size, cell value)
+{
+	return get_impl().count(data, size, value);
+}
+
+size_t aux::find_any_cell(const cell *data, size_t size, const cell *values, size_t count)
+{
+	// unused keys repeat the first value
+	cell keys[max_any_values];
+	for(size_t i = 0; i < max_any_values; i++)
+	{
+		keys[i] = values[i < count ? i : 0];
+	}
+	return get_impl().find_any(data, size, keys);
+}
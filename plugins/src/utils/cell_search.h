@@ -0,0 +1,22 @@
+#ifndef CELL_SEARCH_H_INCLUDED
+#define CELL_SEARCH_H_INCLUDED
+
+#include "sdk/amx/amx.h"
+#include <stddef.h>
+
+namespace aux
+{
+	// Searches for cells equal to value, using SSE2 or AVX2 when the processor supports it.
+
+	// returns the index of the first occurrence, or size if not found
+	size_t find_cell(const cell *data, size_t size, cell value);
+	// returns the index of the last occurrence, or size if not found
+	size_t find_last_cell(const cell *data, size_t size, cell value);
+	size_t count_cell(const cell *data, size_t size, cell value);
+	// returns the index of the first cell equal to any of the values (at most max_any_values), or size if not found
+	size_t find_any_cell(const cell *data, size_t size, const cell *values, size_t count);
+
+	constexpr size_t max_any_values = 4;
+}
+
+#endif
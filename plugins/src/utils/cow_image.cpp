@@ -0,0 +1,167 @@
+#include "cow_image.h"
+#include <cstring>
+
+#ifdef _WIN32
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+namespace aux
+{
+	cow_image::cow_image(const void *data, std::size_t size) : _size(size)
+	{
+		HANDLE mapping = CreateFileMapping(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, static_cast<DWORD>(size), nullptr);
+		if(mapping != nullptr)
+		{
+			void *view = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+			if(view != nullptr)
+			{
+				std::memcpy(view, data, size);
+				UnmapViewOfFile(view);
+				handle = reinterpret_cast<std::intptr_t>(mapping);
+				return;
+			}
+			CloseHandle(mapping);
+		}
+		copy = std::unique_ptr<unsigned char[]>(new unsigned char[size]);
+		std::memcpy(copy.get(), data, size);
+	}
+
+	cow_image::~cow_image()
+	{
+		if(handle != -1)
+		{
+			CloseHandle(reinterpret_cast<HANDLE>(handle));
+		}
+	}
+
+	unsigned char *cow_image::make_copy() const
+	{
+		if(handle != -1)
+		{
+			return static_cast<unsigned char*>(MapViewOfFile(reinterpret_cast<HANDLE>(handle), FILE_MAP_COPY, 0, 0, _size));
+		}
+		unsigned char *data = new unsigned char[_size];
+		std::memcpy(data, copy.get(), _size);
+		return data;
+	}
+
+	unsigned char *cow_image::reset_copy(unsigned char *data) const
+	{
+		if(handle != -1)
+		{
+			UnmapViewOfFile(data);
+			void *view = MapViewOfFileEx(reinterpret_cast<HANDLE>(handle), FILE_MAP_COPY, 0, 0, _size, data);
+			if(view == nullptr)
+			{
+				view = MapViewOfFile(reinterpret_cast<HANDLE>(handle), FILE_MAP_COPY, 0, 0, _size);
+			}
+			return static_cast<unsigned char*>(view);
+		}
+		std::memcpy(data, copy.get(), _size);
+		return data;
+	}
+
+	void cow_image::free_copy(unsigned char *data) const
+	{
+		if(handle != -1)
+		{
+			UnmapViewOfFile(data);
+		}else{
+			delete[] data;
+		}
+	}
+}
+
+#else
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace aux
+{
+	static int create_memory_file()
+	{
+#ifdef SYS_memfd_create
+		return static_cast<int>(syscall(SYS_memfd_create, "pawnplus", 0));
+#else
+		return -1;
+#endif
+	}
+
+	cow_image::cow_image(const void *data, std::size_t size) : _size(size)
+	{
+		int fd = create_memory_file();
+		if(fd != -1)
+		{
+			if(ftruncate(fd, size) == 0)
+			{
+				void *view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+				if(view != MAP_FAILED)
+				{
+					std::memcpy(view, data, size);
+					munmap(view, size);
+					handle = fd;
+					return;
+				}
+			}
+			close(fd);
+		}
+		copy = std::unique_ptr<unsigned char[]>(new unsigned char[size]);
+		std::memcpy(copy.get(), data, size);
+	}
+
+	cow_image::~cow_image()
+	{
+		if(handle != -1)
+		{
+			close(static_cast<int>(handle));
+		}
+	}
+
+	unsigned char *cow_image::make_copy() const
+	{
+		if(handle != -1)
+		{
+			void *view = mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_PRIVATE, static_cast<int>(handle), 0);
+			if(view == MAP_FAILED)
+			{
+				return nullptr;
+			}
+			return static_cast<unsigned char*>(view);
+		}
+		unsigned char *data = new unsigned char[_size];
+		std::memcpy(data, copy.get(), _size);
+		return data;
+	}
+
+	unsigned char *cow_image::reset_copy(unsigned char *data) const
+	{
+		if(handle != -1)
+		{
+			// replaces the modified pages with the original ones
+			void *view = mmap(data, _size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, static_cast<int>(handle), 0);
+			if(view == MAP_FAILED)
+			{
+				munmap(data, _size);
+				return nullptr;
+			}
+			return data;
+		}
+		std::memcpy(data, copy.get(), _size);
+		return data;
+	}
+
+	void cow_image::free_copy(unsigned char *data) const
+	{
+		if(handle != -1)
+		{
+			munmap(data, _size);
+		}else{
+			delete[] data;
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef COW_IMAGE_H_INCLUDED
+#define COW_IMAGE_H_INCLUDED
+
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+namespace aux
+{
+	// Read-only snapshot of a memory block, from which private writable copies can be made.
+	// Copies are mapped copy-on-write when the system supports it, so only modified pages are duplicated.
+	class cow_image
+	{
+		std::size_t _size;
+		std::intptr_t handle = -1;
+		std::unique_ptr<unsigned char[]> copy;
+
+	public:
+		cow_image(const void *data, std::size_t size);
+		cow_image(const cow_image&) = delete;
+		cow_image &operator=(const cow_image&) = delete;
+		~cow_image();
+
+		std::size_t size() const
+		{
+			return _size;
+		}
+
+		bool is_mapped() const
+		{
+			return handle != -1;
+		}
+
+		// returns nullptr if the memory could not be obtained
+		unsigned char *make_copy() const;
+		// discards all changes made to a copy; on failure, the copy is freed and nullptr is returned
+		unsigned char *reset_copy(unsigned char *data) const;
+		void free_copy(unsigned char *data) const;
+	};
+}
+
+#endif
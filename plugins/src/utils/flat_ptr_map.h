@@ -0,0 +1,208 @@
+#ifndef FLAT_PTR_MAP_H_INCLUDED
+#define FLAT_PTR_MAP_H_INCLUDED
+
+#include <vector>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+namespace aux
+{
+	// Open-addressing hash map keyed by non-null pointers, using linear probing and backward-shift deletion.
+	// References to values are invalidated by any insertion or removal.
+	template <class Key, class Value>
+	class flat_ptr_map
+	{
+	public:
+		typedef std::size_t size_type;
+
+	private:
+		struct slot
+		{
+			Key *key = nullptr;
+			Value value;
+		};
+
+		std::vector<slot> slots;
+		size_type count = 0;
+
+		static size_type hash(const Key *key)
+		{
+			std::uintptr_t x = reinterpret_cast<std::uintptr_t>(key);
+			x ^= x >> (sizeof(std::uintptr_t) * 4);
+			x *= static_cast<std::uintptr_t>(0x45d9f3bu);
+			x ^= x >> 16;
+			return static_cast<size_type>(x);
+		}
+
+		size_type mask() const
+		{
+			return slots.size() - 1;
+		}
+
+		size_type find_slot(const Key *key) const
+		{
+			if(count == 0)
+			{
+				return slots.size();
+			}
+			size_type i = hash(key) & mask();
+			while(slots[i].key != nullptr)
+			{
+				if(slots[i].key == key)
+				{
+					return i;
+				}
+				i = (i + 1) & mask();
+			}
+			return slots.size();
+		}
+
+		void rehash(size_type capacity)
+		{
+			std::vector<slot> old(capacity);
+			old.swap(slots);
+			for(auto &s : old)
+			{
+				if(s.key != nullptr)
+				{
+					size_type i = hash(s.key) & mask();
+					while(slots[i].key != nullptr)
+					{
+						i = (i + 1) & mask();
+					}
+					slots[i].key = s.key;
+					slots[i].value = std::move(s.value);
+				}
+			}
+		}
+
+		void erase_slot(size_type i)
+		{
+			size_type j = i;
+			while(true)
+			{
+				j = (j + 1) & mask();
+				if(slots[j].key == nullptr)
+				{
+					break;
+				}
+				size_type home = hash(slots[j].key) & mask();
+				// the element at j can fill the hole at i only if its home is not cyclically in (i, j]
+				if((i <= j) ? (home <= i || home > j) : (home <= i && home > j))
+				{
+					slots[i].key = slots[j].key;
+					slots[i].value = std::move(slots[j].value);
+					i = j;
+				}
+			}
+			slots[i].key = nullptr;
+			slots[i].value = Value();
+			count--;
+		}
+
+	public:
+		flat_ptr_map()
+		{
+
+		}
+
+		flat_ptr_map(flat_ptr_map &&obj) : slots(std::move(obj.slots)), count(obj.count)
+		{
+			obj.slots.clear();
+			obj.count = 0;
+		}
+
+		flat_ptr_map &operator=(flat_ptr_map &&obj)
+		{
+			if(this != &obj)
+			{
+				slots = std::move(obj.slots);
+				count = obj.count;
+				obj.slots.clear();
+				obj.count = 0;
+			}
+			return *this;
+		}
+
+		Value *find(const Key *key)
+		{
+			size_type i = find_slot(key);
+			if(i == slots.size())
+			{
+				return nullptr;
+			}
+			return &slots[i].value;
+		}
+
+		const Value *find(const Key *key) const
+		{
+			size_type i = find_slot(key);
+			if(i == slots.size())
+			{
+				return nullptr;
+			}
+			return &slots[i].value;
+		}
+
+		Value &emplace(Key *key, Value &&value)
+		{
+			if((count + 1) * 4 > slots.size() * 3)
+			{
+				rehash(slots.size() == 0 ? 16 : slots.size() * 2);
+			}
+			size_type i = hash(key) & mask();
+			while(slots[i].key != nullptr)
+			{
+				if(slots[i].key == key)
+				{
+					return slots[i].value;
+				}
+				i = (i + 1) & mask();
+			}
+			slots[i].key = key;
+			slots[i].value = std::move(value);
+			count++;
+			return slots[i].value;
+		}
+
+		// Moves the value out of the map before removing it, so that its destruction happens outside.
+		bool extract(const Key *key, Value &value)
+		{
+			size_type i = find_slot(key);
+			if(i == slots.size())
+			{
+				return false;
+			}
+			value = std::move(slots[i].value);
+			erase_slot(i);
+			return true;
+		}
+
+		template <class Func>
+		void for_each(Func func)
+		{
+			for(auto &s : slots)
+			{
+				if(s.key != nullptr)
+				{
+					func(s.key, s.value);
+				}
+			}
+		}
+
+		size_type size() const
+		{
+			return count;
+		}
+
+		void clear()
+		{
+			std::vector<slot> old;
+			old.swap(slots);
+			count = 0;
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef MPSC_RING_H_INCLUDED
+#define MPSC_RING_H_INCLUDED
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace aux
+{
+	// Bounded lock-free queue with any number of producers and a single consumer.
+	// Every slot has a sequence number telling whether it is free for the producer or ready for the consumer.
+	template <class Type, std::size_t Capacity>
+	class mpsc_ring
+	{
+		static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two.");
+
+		static constexpr std::size_t mask = Capacity - 1;
+
+		struct slot
+		{
+			std::atomic<std::size_t> sequence;
+			Type value;
+		};
+
+		slot slots[Capacity];
+		std::atomic<std::size_t> tail;
+		std::atomic<std::size_t> head;
+
+	public:
+		mpsc_ring() : tail(0), head(0)
+		{
+			for(std::size_t i = 0; i < Capacity; i++)
+			{
+				slots[i].sequence.store(i, std::memory_order_relaxed);
+			}
+		}
+
+		mpsc_ring(const mpsc_ring&) = delete;
+		mpsc_ring &operator=(const mpsc_ring&) = delete;
+
+		// fails if the queue is full
+		bool try_push(const Type &value)
+		{
+			std::size_t pos = tail.load(std::memory_order_relaxed);
+			while(true)
+			{
+				slot &s = slots[pos & mask];
+				std::size_t seq = s.sequence.load(std::memory_order_acquire);
+				std::intptr_t diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+				if(diff == 0)
+				{
+					if(tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					{
+						s.value = value;
+						s.sequence.store(pos + 1, std::memory_order_release);
+						return true;
+					}
+				}else if(diff < 0)
+				{
+					return false;
+				}else{
+					pos = tail.load(std::memory_order_relaxed);
+				}
+			}
+		}
+
+		// must only be called by the consumer
+		bool try_pop(Type &value)
+		{
+			std::size_t pos = head.load(std::memory_order_relaxed);
+			slot &s = slots[pos & mask];
+			std::size_t seq = s.sequence.load(std::memory_order_acquire);
+			if(seq != pos + 1)
+			{
+				return false;
+			}
+			value = s.value;
+			s.sequence.store(pos + Capacity, std::memory_order_release);
+			head.store(pos + 1, std::memory_order_relaxed);
+			return true;
+		}
+
+		// approximate when called concurrently with the producers
+		std::size_t size() const
+		{
+			std::size_t t = tail.load(std::memory_order_relaxed);
+			std::size_t h = head.load(std::memory_order_relaxed);
+			return t > h ? t - h : 0;
+		}
+
+		static constexpr std::size_t capacity()
+		{
+			return Capacity;
+		}
+	};
+}
+
+#endif
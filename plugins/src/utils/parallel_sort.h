@@ -0,0 +1,57 @@
+#ifndef PARALLEL_SORT_H_INCLUDED
+#define PARALLEL_SORT_H_INCLUDED
+
+#include "worker_pool.h"
+
+#include <algorithm>
+#include <vector>
+#include <cstddef>
+
+namespace aux
+{
+	// Sorts parts of the range on the workers and merges them pairwise.
+	// A stable sort gives the same result as std::stable_sort, an unstable one depends only on the number of workers.
+	template <class Iter, class Compare>
+	void parallel_sort(worker_pool &pool, Iter begin, Iter end, Compare comp, bool stable)
+	{
+		std::size_t parts = pool.size() + 1;
+		unsigned long long size = end - begin;
+		std::vector<Iter> bounds;
+		bounds.reserve(parts + 1);
+		for(std::size_t i = 0; i <= parts; i++)
+		{
+			bounds.push_back(begin + static_cast<std::ptrdiff_t>(size * i / parts));
+		}
+
+		std::vector<worker_pool::job> batch;
+		for(std::size_t i = 0; i < parts; i++)
+		{
+			Iter first = bounds[i], last = bounds[i + 1];
+			batch.push_back([=]() mutable
+			{
+				if(stable)
+				{
+					std::stable_sort(first, last, comp);
+				}else{
+					std::sort(first, last, comp);
+				}
+			});
+		}
+		pool.run(batch);
+
+		for(std::size_t width = 1; width < parts; width *= 2)
+		{
+			for(std::size_t i = 0; i + width < parts; i += 2 * width)
+			{
+				Iter first = bounds[i], middle = bounds[i + width], last = bounds[std::min(i + 2 * width, parts)];
+				batch.push_back([=]() mutable
+				{
+					std::inplace_merge(first, middle, last, comp);
+				});
+			}
+			pool.run(batch);
+		}
+	}
+}
+
+#endif
@@ -19,6 +19,7 @@ namespace aux
 			std::condition_variable sync1;
 		};
 		volatile bool started;
+		bool detach_on_exit = true;
 
 		void global_init();
 		void thread_init();
@@ -55,6 +56,12 @@ namespace aux
 		void pause();
 		void resume();
 
+		// must be called before start; the owner is then responsible for joining the thread
+		void keep_joinable()
+		{
+			detach_on_exit = false;
+		}
+
 		~thread()
 		{
 			mutex.~mutex();
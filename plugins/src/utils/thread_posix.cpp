@@ -57,7 +57,10 @@ namespace aux
 
 	void thread::thread_exit()
 	{
-		detach();
+		if(detach_on_exit)
+		{
+			detach();
+		}
 	}
 
 	void thread::start()
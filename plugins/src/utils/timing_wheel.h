@@ -0,0 +1,201 @@
+#ifndef TIMING_WHEEL_H_INCLUDED
+#define TIMING_WHEEL_H_INCLUDED
+
+#include <vector>
+#include <map>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+namespace aux
+{
+	// Hierarchical timing wheel with O(1) insertion and amortized O(1) expiration.
+	// Entries with equal keys expire in the order they were inserted.
+	template <class Value>
+	class timing_wheel
+	{
+	public:
+		typedef std::uint64_t key_type;
+		typedef std::size_t size_type;
+
+	private:
+		static constexpr unsigned slot_bits = 8;
+		static constexpr size_type slot_count = 1 << slot_bits;
+		static constexpr key_type slot_mask = slot_count - 1;
+		static constexpr unsigned level_count = 4;
+		static constexpr key_type wheel_span = static_cast<key_type>(1) << (slot_bits * level_count);
+
+		typedef std::pair<key_type, Value> entry;
+		typedef std::vector<entry> slot;
+
+		slot slots[level_count][slot_count];
+		size_type level_sizes[level_count] = {};
+		std::multimap<key_type, Value> overflow;
+		key_type current = 0;
+		size_type count = 0;
+
+		void place(key_type key, Value &&value)
+		{
+			key_type diff = key ^ current;
+			for(unsigned level = 0; level < level_count; level++)
+			{
+				if(diff < (static_cast<key_type>(1) << (slot_bits * (level + 1))))
+				{
+					slots[level][(key >> (slot_bits * level)) & slot_mask].emplace_back(key, std::move(value));
+					level_sizes[level]++;
+					return;
+				}
+			}
+			overflow.emplace(key, std::move(value));
+		}
+
+		void cascade(unsigned level)
+		{
+			slot moved;
+			moved.swap(slots[level][(current >> (slot_bits * level)) & slot_mask]);
+			level_sizes[level] -= moved.size();
+			for(auto &e : moved)
+			{
+				place(e.first, std::move(e.second));
+			}
+		}
+
+		void cascade_overflow()
+		{
+			auto it = overflow.begin();
+			while(it != overflow.end() && it->first - current < wheel_span)
+			{
+				place(it->first, std::move(it->second));
+				it = overflow.erase(it);
+			}
+		}
+
+		template <class Func>
+		void step(Func &func)
+		{
+			current++;
+			if((current & slot_mask) == 0)
+			{
+				unsigned top = 1;
+				while(top < level_count && (current & ((static_cast<key_type>(1) << (slot_bits * (top + 1))) - 1)) == 0)
+				{
+					top++;
+				}
+				if(top == level_count)
+				{
+					cascade_overflow();
+					top--;
+				}
+				for(unsigned level = top; level >= 1; level--)
+				{
+					cascade(level);
+				}
+			}
+
+			auto &due = slots[0][current & slot_mask];
+			if(due.empty())
+			{
+				return;
+			}
+			slot fired;
+			fired.swap(due);
+			level_sizes[0] -= fired.size();
+			count -= fired.size();
+			for(auto &e : fired)
+			{
+				func(std::move(e.second));
+			}
+			fired.clear();
+			if(due.empty())
+			{
+				due.swap(fired);
+			}
+		}
+
+	public:
+		// Keys not later than the current time are moved to the next time unit.
+		void insert(key_type key, Value &&value)
+		{
+			if(key <= current)
+			{
+				key = current + 1;
+			}
+			place(key, std::move(value));
+			count++;
+		}
+
+		// Moves the current time to target, calling func for every expired value in order.
+		template <class Func>
+		void advance(key_type target, Func func)
+		{
+			while(current < target)
+			{
+				if(count == 0)
+				{
+					current = target;
+					break;
+				}
+				unsigned empty_levels = 0;
+				while(empty_levels < level_count && level_sizes[empty_levels] == 0)
+				{
+					empty_levels++;
+				}
+				if(empty_levels > 0)
+				{
+					// nothing can expire or cascade before the next boundary of the first non-empty level
+					key_type span = empty_levels < level_count ? static_cast<key_type>(1) << (slot_bits * empty_levels) : wheel_span;
+					key_type boundary = (current | (span - 1)) + 1;
+					if(boundary > target)
+					{
+						current = target;
+						break;
+					}
+					current = boundary - 1;
+				}
+				step(func);
+			}
+		}
+
+		// Changes the current time; only allowed when the wheel is empty.
+		bool rewind(key_type time)
+		{
+			if(count != 0)
+			{
+				return false;
+			}
+			current = time;
+			return true;
+		}
+
+		key_type time() const
+		{
+			return current;
+		}
+
+		size_type size() const
+		{
+			return count;
+		}
+
+		bool empty() const
+		{
+			return count == 0;
+		}
+
+		void clear()
+		{
+			for(unsigned level = 0; level < level_count; level++)
+			{
+				for(auto &s : slots[level])
+				{
+					slot().swap(s);
+				}
+				level_sizes[level] = 0;
+			}
+			overflow.clear();
+			count = 0;
+		}
+	};
+}
+
+#endif
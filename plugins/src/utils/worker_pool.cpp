@@ -0,0 +1,104 @@
+#include "worker_pool.h"
+
+namespace aux
+{
+	void worker_pool::resize(std::size_t count)
+	{
+		std::lock_guard<std::mutex> batch_lock(batch_mutex);
+		if(!threads.empty())
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				stopping = true;
+			}
+			job_ready.notify_all();
+			for(auto &thread : threads)
+			{
+				thread.join();
+			}
+			threads.clear();
+			stopping = false;
+		}
+		threads.reserve(count);
+		for(std::size_t i = 0; i < count; i++)
+		{
+			threads.emplace_back(&worker_pool::worker, this);
+		}
+	}
+
+	bool worker_pool::run_one(std::unique_lock<std::mutex> &lock)
+	{
+		if(jobs.empty())
+		{
+			return false;
+		}
+		job current = std::move(jobs.front());
+		jobs.pop_front();
+		lock.unlock();
+		try{
+			current();
+		}catch(...)
+		{
+			lock.lock();
+			if(!error)
+			{
+				error = std::current_exception();
+			}
+			lock.unlock();
+		}
+		lock.lock();
+		if(--pending == 0)
+		{
+			batch_done.notify_all();
+		}
+		return true;
+	}
+
+	void worker_pool::worker()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		while(true)
+		{
+			if(!run_one(lock))
+			{
+				if(stopping)
+				{
+					break;
+				}
+				job_ready.wait(lock);
+			}
+		}
+	}
+
+	void worker_pool::run(std::vector<job> &batch)
+	{
+		std::lock_guard<std::mutex> batch_lock(batch_mutex);
+		std::unique_lock<std::mutex> lock(mutex);
+		for(auto &j : batch)
+		{
+			jobs.push_back(std::move(j));
+		}
+		pending = jobs.size();
+		batch.clear();
+		lock.unlock();
+		job_ready.notify_all();
+		lock.lock();
+
+		while(run_one(lock))
+		{
+
+		}
+		while(pending > 0)
+		{
+			batch_done.wait(lock);
+		}
+
+		std::exception_ptr ex;
+		std::swap(ex, error);
+		lock.unlock();
+		if(ex)
+		{
+			std::rethrow_exception(ex);
+		}
+	}
+}
@@ -0,0 +1,63 @@
+#ifndef WORKER_POOL_H_INCLUDED
+#define WORKER_POOL_H_INCLUDED
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <vector>
+#include <deque>
+#include <cstddef>
+
+namespace aux
+{
+	// Set of worker threads executing batches of jobs.
+	// The thread submitting a batch takes part in it and waits until all its jobs have finished.
+	class worker_pool
+	{
+	public:
+		typedef std::function<void()> job;
+
+	private:
+		std::vector<std::thread> threads;
+		std::mutex mutex;
+		std::mutex batch_mutex;
+		std::condition_variable job_ready;
+		std::condition_variable batch_done;
+		std::deque<job> jobs;
+		std::size_t pending = 0;
+		std::exception_ptr error;
+		bool stopping = false;
+
+		void worker();
+		bool run_one(std::unique_lock<std::mutex> &lock);
+
+	public:
+		worker_pool()
+		{
+
+		}
+
+		worker_pool(const worker_pool&) = delete;
+		worker_pool &operator=(const worker_pool&) = delete;
+
+		~worker_pool()
+		{
+			resize(0);
+		}
+
+		std::size_t size() const
+		{
+			return threads.size();
+		}
+
+		// stops and joins all current threads before starting the new ones
+		void resize(std::size_t count);
+
+		// rethrows the first exception thrown by a job
+		void run(std::vector<job> &batch);
+	};
+}
+
+#endif